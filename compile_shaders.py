@@ -1,7 +1,11 @@
 import os
+import re
 import shutil
 import zipfile
 
+# Generates the shader string headers, typed program bindings and std140 block structs in include/shaders.
+# Not part of the build, run it by hand after editing anything in shaders/ and commit the result.
+
 shader_folder = "./shaders"
 
 shader_header_folder = "./include/shaders"
@@ -27,13 +31,274 @@ constexpr const char* {shader_name.replace(".","_")} = {lines};
 """
 
 
+# Reflection
+# Parses the uniforms, samplers and uniform blocks of every shader, so that C++ can refer to them
+# through generated struct members instead of string literals.
+
+# GLSL uniform type -> C++ type accepted by Shader::set
+uniform_types = {
+    "bool": "bool",
+    "int": "int",
+    "float": "float",
+}
+
+# GLSL sampler type -> texture target
+sampler_types = {
+    "sampler2D": "GL_TEXTURE_2D",
+    "sampler3D": "GL_TEXTURE_3D",
+    "samplerCube": "GL_TEXTURE_CUBE_MAP",
+    "sampler2DArray": "GL_TEXTURE_2D_ARRAY",
+}
+
+# GLSL block member type -> (C++ element type, component count, std140 base alignment)
+block_member_types = {
+    "float": ("float", 1, 4),
+    "int": ("int32_t", 1, 4),
+    "uint": ("uint32_t", 1, 4),
+    "bool": ("uint32_t", 1, 4),
+    "vec2": ("float", 2, 8),
+    "vec3": ("float", 3, 16),
+    "vec4": ("float", 4, 16),
+    "ivec2": ("int32_t", 2, 8),
+    "ivec3": ("int32_t", 3, 16),
+    "ivec4": ("int32_t", 4, 16),
+    "mat4": ("float", 16, 16),
+}
+
+precision_pattern = r"(?:(?:lowp|mediump|highp)\s+)?"
+layout_pattern = r"(?:layout\s*\(([^)]*)\)\s*)?"
+uniform_pattern = re.compile(layout_pattern + r"uniform\s+" + precision_pattern + r"(\w+)\s+(\w+)\s*(?:\[\s*(\d+)\s*\])?\s*;")
+block_pattern = re.compile(layout_pattern + r"uniform\s+(\w+)\s*\{([^}]*)\}\s*(\w+)?\s*;")
+member_pattern = re.compile(precision_pattern + r"(\w+)\s+(.+)")
+declarator_pattern = re.compile(r"(\w+)\s*(?:\[\s*(\d+)\s*\])?")
+
+
+def strip_comments(source):
+    source = re.sub(r"/\*.*?\*/", "", source, flags=re.S)
+    return re.sub(r"//[^\n]*", "", source)
+
+
+def layout_qualifiers(layout):
+    qualifiers = {}
+    if layout is None:
+        return qualifiers
+
+    for qualifier in layout.split(","):
+        key, _, value = qualifier.partition("=")
+        qualifiers[key.strip()] = value.strip()
+    return qualifiers
+
+
+def align(offset, alignment):
+    return (offset + alignment - 1) // alignment * alignment
+
+
+def block_members(block_name, body):
+    """Splits a block body into (type, name, array size) members, one per declarator of `float a, b[2];`"""
+    members = []
+    for statement in body.split(";"):
+        statement = statement.strip()
+        if not statement:
+            continue
+
+        # anything not understood would silently shift the layout of every following member
+        match = member_pattern.fullmatch(statement)
+        if match is None:
+            raise Exception(f"Unable to parse member `{statement}` of {block_name}")
+        glsl_type, declarators = match.groups()
+
+        for declarator in declarators.split(","):
+            declarator_match = declarator_pattern.fullmatch(declarator.strip())
+            if declarator_match is None:
+                raise Exception(f"Unable to parse member `{statement}` of {block_name}")
+            name, array_size = declarator_match.groups()
+            members.append((glsl_type, name, array_size))
+    return members
+
+
+def std140_members(block_name, body):
+    """Lays out the members of a block by the std140 rules, inserting explicit padding"""
+    members = []
+    offset = 0
+    pad_count = 0
+
+    def pad_to(target):
+        nonlocal offset, pad_count
+        if target > offset:
+            members.append((f"uint8_t _pad{pad_count}[{target - offset}];", None, None))
+            pad_count += 1
+            offset = target
+
+    for glsl_type, name, array_size in block_members(block_name, body):
+        if glsl_type not in block_member_types:
+            raise Exception(f"Unsupported type {glsl_type} for {block_name}.{name}")
+        cpp_type, components, alignment = block_member_types[glsl_type]
+
+        if array_size:
+            # every array element is rounded up to a vec4
+            pad_to(align(offset, 16))
+            element = f"Std140Element<{cpp_type}>" if components == 1 else f"Std140Element<{cpp_type}[{components}]>"
+            members.append((f"{element} {name}[{array_size}];", name, offset))
+            offset += align(components * 4, 16) * int(array_size)
+        else:
+            pad_to(align(offset, alignment))
+            declaration = f"{cpp_type} {name};" if components == 1 else f"{cpp_type} {name}[{components}];"
+            members.append((declaration, name, offset))
+            offset += components * 4
+
+    pad_to(align(offset, 16))
+    return members, offset
+
+
+def reflect(source):
+    source = strip_comments(source)
+
+    blocks = {}
+    for layout, block_name, body, _ in block_pattern.findall(source):
+        qualifiers = layout_qualifiers(layout)
+        if "std140" not in qualifiers:
+            raise Exception(f"Uniform block {block_name} must be declared std140")
+        if "binding" not in qualifiers:
+            raise Exception(f"Uniform block {block_name} must declare a binding")
+        blocks[block_name] = (int(qualifiers["binding"]), " ".join(body.split()))
+
+    # remove the blocks so their members aren't picked up as plain uniforms
+    source = block_pattern.sub("", source)
+
+    uniforms = {}
+    samplers = {}
+    for layout, glsl_type, name, array_size in uniform_pattern.findall(source):
+        if glsl_type in sampler_types:
+            binding = layout_qualifiers(layout).get("binding")
+            samplers[name] = (glsl_type, None if binding is None else int(binding))
+        elif glsl_type in uniform_types and not array_size:
+            uniforms[name] = glsl_type
+        else:
+            raise Exception(f"Unsupported uniform type {glsl_type} for {name}")
+
+    return uniforms, samplers, blocks
+
+
+def merge(stage_name, target, source):
+    for name, value in source.items():
+        if name in target and target[name] != value:
+            raise Exception(f"{name} is declared differently in {stage_name}")
+        target[name] = value
+
+
+def program_name(name):
+    return "".join(part.capitalize() for part in name.split("_")) + "Program"
+
+
+def program_file(name, uniforms, samplers, blocks):
+    # texture units follow explicit layout bindings, the rest are handed out in declaration order
+    units = {}
+    used_units = {binding for _, binding in samplers.values() if binding is not None}
+    next_unit = 0
+    for sampler_name, (_, binding) in samplers.items():
+        if binding is None:
+            while next_unit in used_units:
+                next_unit += 1
+            binding = next_unit
+            used_units.add(binding)
+        units[sampler_name] = binding
+
+    members = ""
+    initializers = ""
+    for sampler_name, (glsl_type, _) in samplers.items():
+        members += f"        Sampler<{sampler_types[glsl_type]}> {sampler_name};\n"
+        initializers += f"            {sampler_name} = sampler<{sampler_types[glsl_type]}>(\"{sampler_name}\", {units[sampler_name]});\n"
+    for uniform_name, glsl_type in uniforms.items():
+        members += f"        Uniform<{uniform_types[glsl_type]}> {uniform_name};\n"
+        initializers += f"            {uniform_name} = uniform<{uniform_types[glsl_type]}>(\"{uniform_name}\");\n"
+
+    block_members = ""
+    if blocks:
+        block_members = "        // uniform blocks, bound through their layout binding\n"
+    for block_name in blocks:
+        block_members += f"        using {block_name} = Blocks::{block_name};\n"
+    if blocks:
+        block_members += "\n"
+
+    struct_name = program_name(name)
+    return f"""// Generated by compile_shaders.py from {name}_vs.glsl and {name}_fs.glsl, do not edit.
+#pragma once
+
+#include "opengl/Shader.hpp"
+#include "shaders/uniform_blocks.hpp"
+
+namespace Shaders {{
+    struct {struct_name} : public Shader {{
+{block_members}{members}
+        {struct_name}() = default;
+        {struct_name}(const char* vertexCode, const char* fragmentCode) : Shader(vertexCode, fragmentCode) {{
+            use();
+{initializers}        }}
+    }};
+}}
+"""
+
+
+def blocks_file(blocks):
+    structs = ""
+    for block_name, (binding, body) in blocks.items():
+        members, size = std140_members(block_name, body)
+
+        declarations = "".join(f"        {declaration}\n" for declaration, _, _ in members)
+        asserts = "".join(f"    static_assert(offsetof({block_name}, {member}) == {offset});\n"
+                          for _, member, offset in members if member is not None)
+        structs += f"""
+    // uniform {block_name}, std140
+    struct {block_name} {{
+        static constexpr GLuint binding = {binding};
+
+{declarations}    }};
+    static_assert(sizeof({block_name}) == {size});
+{asserts}"""
+
+    return f"""// Generated by compile_shaders.py, do not edit.
+#pragma once
+
+#include "opengl/Std140.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Shaders::Blocks {{{structs}}}
+"""
+
+
+programs = {}
+
 for shader_name in os.listdir(shader_folder):
     file_path = os.path.join(shader_folder, shader_name)
     print(f"Making header {shader_name}.hpp in {shader_header_folder}")
 
     with open(f"{file_path}", "r") as original_shader_file:
         with open(f"{shader_header_folder}/{shader_name}.hpp", "w") as file_converted:
-            shader_header_code = shader_file(shader_name, original_shader_file.readlines())
+            shader_contents = original_shader_file.readlines()
+            shader_header_code = shader_file(shader_name, shader_contents)
             file_converted.write(shader_header_code)
 
-print("Done making shaders!")
\ No newline at end of file
+    # name_vs.glsl / name_fs.glsl make up the program "name"
+    stage_match = re.fullmatch(r"(\w+)_(vs|fs)\.glsl", shader_name)
+    if stage_match is None:
+        continue
+
+    program = programs.setdefault(stage_match.group(1), ({}, {}, {}))
+    for target, source in zip(program, reflect("".join(shader_contents))):
+        merge(shader_name, target, source)
+
+all_blocks = {}
+for name in sorted(programs):
+    uniforms, samplers, blocks = programs[name]
+    merge(name, all_blocks, blocks)
+
+    print(f"Making header {name}_program.hpp in {shader_header_folder}")
+    with open(f"{shader_header_folder}/{name}_program.hpp", "w") as program_header:
+        program_header.write(program_file(name, uniforms, samplers, blocks))
+
+with open(f"{shader_header_folder}/uniform_blocks.hpp", "w") as blocks_header:
+    blocks_header.write(blocks_file(dict(sorted(all_blocks.items()))))
+
+print("Done making shaders!")
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// Typed view of the config file. A published snapshot is never modified, a change publishes a new one
+struct BloomSettings {
+    // number of Gaussian blur passes, alternating between horizontal and vertical
+    int blurPasses = 10;
+    float exposure = 1.0f;
+    // see ChangeDetector::Threshold and ChangeDetector::StaticFramesBeforeReuse
+    int changeThreshold = 2;
+    int staticFramesBeforeReuse = 3;
+};
+
+// The config file is only read and written by the config thread, everyone else reads the published snapshot
+namespace BloomConfig {
+    // what changed between two snapshots, so the render thread only rebuilds what depends on it
+    enum Change : uint32_t {
+        None = 0,
+        BlurPasses = 1 << 0,
+        Exposure = 1 << 1,
+        ChangeDetection = 1 << 2,
+    };
+
+    // reads the config file and publishes the first snapshot. Must be called before anything reads the settings
+    void load();
+
+    // the latest snapshot. Lock-free and safe on any thread, the reference stays valid for the whole session
+    BloomSettings const& current();
+    // Change flags of everything published since the last call. Meant for the render thread, the only consumer
+    uint32_t takeChanges();
+
+    // re-reads the config file on the config thread, to pick up edits made while the game is running
+    void reload();
+    // applies a change on the config thread, which saves it to disk and publishes a new snapshot
+    void update(std::function<void(BloomSettings&)> change);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "GLTrace.hpp"
+#include "Shaders.hpp"
+
+#include <cstdint>
+
+
+// Detects frames whose content didn't change, so the blurred result of an earlier frame can be reused.
+// Every frame a tiny luminance signature of the scene is rendered and compared on the GPU, against both the
+// previous frame and the frame the cached blur came from. Only the differences are read back, asynchronously through
+// a ring of pixel buffers and fences, so the result lags a couple of frames behind but never stalls the render thread.
+class ChangeDetector
+{
+public:
+    // signature resolution, in cells
+    static constexpr int SignatureSize = 16;
+    // readbacks that can be in flight at once
+    static constexpr int ReadbackSlots = 3;
+
+    // largest per-cell luminance difference (out of 255) that still counts as unchanged
+    uint8_t Threshold = 2;
+    // unchanged frames in a row before the cached blur is reused
+    int StaticFramesBeforeReuse = 3;
+
+    ChangeDetector() = default;
+
+    // creates the signature targets and readback buffers
+    void initialize();
+    // renders the signature of `sceneTexture` and queues its readback. Call once per frame before canReuse().
+    // Changes the viewport, it is restored to `viewport` (x, y, width, height)
+    void update(GLuint sceneTexture, GLint const (&viewport)[4]);
+    // whether the blur computed before the last markRecomputed() can be used for this frame
+    bool canReuse() const;
+    // call after the blur was recomputed, this frame's signature becomes the reference
+    void markRecomputed();
+    // forget the reference and every readback still in flight, e.g. when the blur targets were recreated.
+    // The blur is recomputed until StaticFramesBeforeReuse new frames have been read back
+    void invalidate();
+
+private:
+    struct Readback {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+    };
+
+    Shaders::SignatureProgram shader;
+    GLuint emptyVAO = 0;
+
+    // two signatures that alternate between this and the previous frame, and the reference
+    static constexpr int ReferenceSignature = 2;
+    GLuint signatures[3] = {};
+    GLuint signatureFBOs[3] = {};
+    int currentSignature = 0;
+    bool hasReference = false;
+
+    Readback readbacks[ReadbackSlots];
+    int nextReadback = 0;
+
+    int staticFrames = 0;
+    bool reuse = false;
+
+    // maps every readback whose fence has been signalled, oldest first
+    void collectReadbacks();
+};
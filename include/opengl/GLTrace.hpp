@@ -0,0 +1,365 @@
+#pragma once
+
+// Opt-in recorder for the GL calls made by the bloom pipeline, enabled by configuring with -DBLOOM_GL_TRACE=ON.
+// Every traced call and its arguments are appended to a preallocated buffer on the render thread,
+// full buffers are written to disk by a background thread. tools/gl_replay re-executes and times the result.
+//
+// Include this instead of the GLES headers in any file that issues GL calls that should show up in the trace.
+// Without BLOOM_GL_TRACE the GL functions are left untouched and the recorder functions are no-ops.
+
+#include <GLES3/gl3.h>
+#include <GLES3/gl31.h>
+#include <GLES3/gl32.h>
+#include <GLES3/gl3ext.h>
+
+#include "GLTraceFormat.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GLTrace {
+    // about 20 seconds at 90 Hz, long enough for a repro without the file growing for the whole session
+    constexpr uint32_t DefaultFrameLimit = 1800;
+
+#ifdef BLOOM_GL_TRACE
+    // Allocates the recording buffers and starts the writer thread. Only the first call has any effect,
+    // a recording that was stopped isn't restarted. Recording stops by itself after `frameLimit` frames.
+    void start(const char* path, uint32_t frameLimit = DefaultFrameLimit);
+    // Closes the current frame. Must be called on the render thread.
+    void endFrame();
+    // Hands the recorded frames to the writer, waits until they are on disk and closes the file.
+    // Must be called on the render thread, calls after it are no longer recorded.
+    void stop();
+
+    // Appends a single call to the current frame. Anything that doesn't fit is dropped and counted.
+    class Call {
+    public:
+        explicit Call(Op op);
+        ~Call();
+
+        Call(Call const&) = delete;
+        Call& operator=(Call const&) = delete;
+
+        Call& operator<<(uint32_t value);
+        Call& operator<<(int32_t value);
+        Call& operator<<(float value);
+        Call& operator<<(uint64_t value);
+        Call& operator<<(int64_t value);
+
+        // blob header, followed by exactly `size` bytes of append() and then endBlob()
+        Call& beginBlob(size_t size);
+        Call& append(const void* data, size_t size);
+        Call& endBlob();
+
+        Call& blob(const void* data, size_t size) {
+            return beginBlob(size).append(data, size).endBlob();
+        }
+
+        Call& names(GLsizei n, const GLuint* names);
+
+    private:
+        size_t start;
+        size_t blobStart = 0;
+        size_t blobBytes = 0;
+        bool recording;
+    };
+
+    namespace Hooks {
+        inline void glActiveTexture(GLenum texture) {
+            ::glActiveTexture(texture);
+            Call(Op::ActiveTexture) << texture;
+        }
+
+        inline void glAttachShader(GLuint program, GLuint shader) {
+            ::glAttachShader(program, shader);
+            Call(Op::AttachShader) << program << shader;
+        }
+
+        inline void glBindBuffer(GLenum target, GLuint buffer) {
+            ::glBindBuffer(target, buffer);
+            Call(Op::BindBuffer) << target << buffer;
+        }
+
+        inline void glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+            ::glBindBufferRange(target, index, buffer, offset, size);
+            Call(Op::BindBufferRange) << target << index << buffer << int64_t(offset) << int64_t(size);
+        }
+
+        inline void glBindFramebuffer(GLenum target, GLuint framebuffer) {
+            ::glBindFramebuffer(target, framebuffer);
+            Call(Op::BindFramebuffer) << target << framebuffer;
+        }
+
+        inline void glBindTexture(GLenum target, GLuint texture) {
+            ::glBindTexture(target, texture);
+            Call(Op::BindTexture) << target << texture;
+        }
+
+        inline void glBindVertexArray(GLuint array) {
+            ::glBindVertexArray(array);
+            Call(Op::BindVertexArray) << array;
+        }
+
+        inline void glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
+            ::glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+            Call(Op::BlitFramebuffer) << srcX0 << srcY0 << srcX1 << srcY1 << dstX0 << dstY0 << dstX1 << dstY1 << mask << filter;
+        }
+
+        inline void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+            ::glBufferData(target, size, data, usage);
+            (Call(Op::BufferData) << target << int64_t(size) << usage).blob(data, data ? size : 0);
+        }
+
+        inline void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+            ::glBufferSubData(target, offset, size, data);
+            (Call(Op::BufferSubData) << target << int64_t(offset)).blob(data, size);
+        }
+
+        inline void glClear(GLbitfield mask) {
+            ::glClear(mask);
+            Call(Op::Clear) << mask;
+        }
+
+        inline GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+            GLenum status = ::glClientWaitSync(sync, flags, timeout);
+            Call(Op::ClientWaitSync) << uint64_t(reinterpret_cast<uintptr_t>(sync)) << flags << uint64_t(timeout) << status;
+            return status;
+        }
+
+        inline void glCompileShader(GLuint shader) {
+            ::glCompileShader(shader);
+            Call(Op::CompileShader) << shader;
+        }
+
+        inline GLuint glCreateProgram() {
+            GLuint program = ::glCreateProgram();
+            Call(Op::CreateProgram) << program;
+            return program;
+        }
+
+        inline GLuint glCreateShader(GLenum type) {
+            GLuint shader = ::glCreateShader(type);
+            Call(Op::CreateShader) << type << shader;
+            return shader;
+        }
+
+        inline void glDeleteBuffers(GLsizei n, const GLuint* buffers) {
+            Call(Op::DeleteBuffers).names(n, buffers);
+            ::glDeleteBuffers(n, buffers);
+        }
+
+        inline void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+            Call(Op::DeleteFramebuffers).names(n, framebuffers);
+            ::glDeleteFramebuffers(n, framebuffers);
+        }
+
+        inline void glDeleteShader(GLuint shader) {
+            ::glDeleteShader(shader);
+            Call(Op::DeleteShader) << shader;
+        }
+
+        inline void glDeleteSync(GLsync sync) {
+            ::glDeleteSync(sync);
+            Call(Op::DeleteSync) << uint64_t(reinterpret_cast<uintptr_t>(sync));
+        }
+
+        inline void glDeleteTextures(GLsizei n, const GLuint* textures) {
+            Call(Op::DeleteTextures).names(n, textures);
+            ::glDeleteTextures(n, textures);
+        }
+
+        inline void glDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+            Call(Op::DeleteVertexArrays).names(n, arrays);
+            ::glDeleteVertexArrays(n, arrays);
+        }
+
+        inline void glDisable(GLenum cap) {
+            ::glDisable(cap);
+            Call(Op::Disable) << cap;
+        }
+
+        inline void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+            ::glDrawArrays(mode, first, count);
+            Call(Op::DrawArrays) << mode << first << count;
+        }
+
+        inline void glEnableVertexAttribArray(GLuint index) {
+            ::glEnableVertexAttribArray(index);
+            Call(Op::EnableVertexAttribArray) << index;
+        }
+
+        inline GLsync glFenceSync(GLenum condition, GLbitfield flags) {
+            GLsync sync = ::glFenceSync(condition, flags);
+            Call(Op::FenceSync) << condition << flags << uint64_t(reinterpret_cast<uintptr_t>(sync));
+            return sync;
+        }
+
+        inline void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+            ::glFramebufferTexture2D(target, attachment, textarget, texture, level);
+            Call(Op::FramebufferTexture2D) << target << attachment << textarget << texture << level;
+        }
+
+        inline void glGenBuffers(GLsizei n, GLuint* buffers) {
+            ::glGenBuffers(n, buffers);
+            Call(Op::GenBuffers).names(n, buffers);
+        }
+
+        inline void glGenFramebuffers(GLsizei n, GLuint* framebuffers) {
+            ::glGenFramebuffers(n, framebuffers);
+            Call(Op::GenFramebuffers).names(n, framebuffers);
+        }
+
+        inline void glGenTextures(GLsizei n, GLuint* textures) {
+            ::glGenTextures(n, textures);
+            Call(Op::GenTextures).names(n, textures);
+        }
+
+        inline void glGenVertexArrays(GLsizei n, GLuint* arrays) {
+            ::glGenVertexArrays(n, arrays);
+            Call(Op::GenVertexArrays).names(n, arrays);
+        }
+
+        inline GLint glGetUniformLocation(GLuint program, const GLchar* name) {
+            GLint location = ::glGetUniformLocation(program, name);
+            size_t length = 0;
+            while (name[length] != '\0') length++;
+            (Call(Op::GetUniformLocation) << program).blob(name, length) << location;
+            return location;
+        }
+
+        inline void glLinkProgram(GLuint program) {
+            ::glLinkProgram(program);
+            Call(Op::LinkProgram) << program;
+        }
+
+        inline void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+            void* pointer = ::glMapBufferRange(target, offset, length, access);
+            Call(Op::MapBufferRange) << target << int64_t(offset) << int64_t(length) << access;
+            return pointer;
+        }
+
+        inline void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) {
+            ::glReadPixels(x, y, width, height, format, type, pixels);
+            Call(Op::ReadPixels) << x << y << width << height << format << type << uint64_t(reinterpret_cast<uintptr_t>(pixels));
+        }
+
+        inline void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length) {
+            ::glShaderSource(shader, count, string, length);
+
+            auto partLength = [&](GLsizei i) -> size_t {
+                if (length && length[i] >= 0) return length[i];
+                size_t l = 0;
+                while (string[i][l] != '\0') l++;
+                return l;
+            };
+
+            size_t total = 0;
+            for (GLsizei i = 0; i < count; i++) total += partLength(i);
+
+            Call call(Op::ShaderSource);
+            call << shader;
+            call.beginBlob(total);
+            for (GLsizei i = 0; i < count; i++) call.append(string[i], partLength(i));
+            call.endBlob();
+        }
+
+        inline void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels) {
+            ::glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+            Call(Op::TexImage2D) << target << level << internalformat << width << height << border << format << type;
+        }
+
+        inline void glTexParameteri(GLenum target, GLenum pname, GLint param) {
+            ::glTexParameteri(target, pname, param);
+            Call(Op::TexParameteri) << target << pname << param;
+        }
+
+        inline void glTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height) {
+            ::glTexStorage2D(target, levels, internalformat, width, height);
+            Call(Op::TexStorage2D) << target << levels << internalformat << width << height;
+        }
+
+        inline void glUniform1f(GLint location, GLfloat v0) {
+            ::glUniform1f(location, v0);
+            Call(Op::Uniform1f) << location << v0;
+        }
+
+        inline void glUniform1i(GLint location, GLint v0) {
+            ::glUniform1i(location, v0);
+            Call(Op::Uniform1i) << location << v0;
+        }
+
+        inline GLboolean glUnmapBuffer(GLenum target) {
+            GLboolean result = ::glUnmapBuffer(target);
+            Call(Op::UnmapBuffer) << target;
+            return result;
+        }
+
+        inline void glUseProgram(GLuint program) {
+            ::glUseProgram(program);
+            Call(Op::UseProgram) << program;
+        }
+
+        inline void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer) {
+            ::glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+            Call(Op::VertexAttribPointer) << index << size << type << uint32_t(normalized) << stride << uint64_t(reinterpret_cast<uintptr_t>(pointer));
+        }
+
+        inline void glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+            ::glViewport(x, y, width, height);
+            Call(Op::Viewport) << x << y << width << height;
+        }
+    }
+#else
+    inline void start(const char*, uint32_t = DefaultFrameLimit) {}
+    inline void endFrame() {}
+    inline void stop() {}
+#endif
+}
+
+#ifdef BLOOM_GL_TRACE
+// Route the traced entry points through the hooks above. The GLES headers were included first, so their declarations are unaffected.
+#define glActiveTexture GLTrace::Hooks::glActiveTexture
+#define glAttachShader GLTrace::Hooks::glAttachShader
+#define glBindBuffer GLTrace::Hooks::glBindBuffer
+#define glBindBufferRange GLTrace::Hooks::glBindBufferRange
+#define glBindFramebuffer GLTrace::Hooks::glBindFramebuffer
+#define glBindTexture GLTrace::Hooks::glBindTexture
+#define glBindVertexArray GLTrace::Hooks::glBindVertexArray
+#define glBlitFramebuffer GLTrace::Hooks::glBlitFramebuffer
+#define glBufferData GLTrace::Hooks::glBufferData
+#define glBufferSubData GLTrace::Hooks::glBufferSubData
+#define glClear GLTrace::Hooks::glClear
+#define glClientWaitSync GLTrace::Hooks::glClientWaitSync
+#define glCompileShader GLTrace::Hooks::glCompileShader
+#define glCreateProgram GLTrace::Hooks::glCreateProgram
+#define glCreateShader GLTrace::Hooks::glCreateShader
+#define glDeleteBuffers GLTrace::Hooks::glDeleteBuffers
+#define glDeleteFramebuffers GLTrace::Hooks::glDeleteFramebuffers
+#define glDeleteShader GLTrace::Hooks::glDeleteShader
+#define glDeleteSync GLTrace::Hooks::glDeleteSync
+#define glDeleteTextures GLTrace::Hooks::glDeleteTextures
+#define glDeleteVertexArrays GLTrace::Hooks::glDeleteVertexArrays
+#define glDisable GLTrace::Hooks::glDisable
+#define glDrawArrays GLTrace::Hooks::glDrawArrays
+#define glEnableVertexAttribArray GLTrace::Hooks::glEnableVertexAttribArray
+#define glFenceSync GLTrace::Hooks::glFenceSync
+#define glFramebufferTexture2D GLTrace::Hooks::glFramebufferTexture2D
+#define glGenBuffers GLTrace::Hooks::glGenBuffers
+#define glGenFramebuffers GLTrace::Hooks::glGenFramebuffers
+#define glGenTextures GLTrace::Hooks::glGenTextures
+#define glGenVertexArrays GLTrace::Hooks::glGenVertexArrays
+#define glGetUniformLocation GLTrace::Hooks::glGetUniformLocation
+#define glLinkProgram GLTrace::Hooks::glLinkProgram
+#define glMapBufferRange GLTrace::Hooks::glMapBufferRange
+#define glReadPixels GLTrace::Hooks::glReadPixels
+#define glShaderSource GLTrace::Hooks::glShaderSource
+#define glTexImage2D GLTrace::Hooks::glTexImage2D
+#define glTexParameteri GLTrace::Hooks::glTexParameteri
+#define glTexStorage2D GLTrace::Hooks::glTexStorage2D
+#define glUniform1f GLTrace::Hooks::glUniform1f
+#define glUniform1i GLTrace::Hooks::glUniform1i
+#define glUnmapBuffer GLTrace::Hooks::glUnmapBuffer
+#define glUseProgram GLTrace::Hooks::glUseProgram
+#define glVertexAttribPointer GLTrace::Hooks::glVertexAttribPointer
+#define glViewport GLTrace::Hooks::glViewport
+#endif
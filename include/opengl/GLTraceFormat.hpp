@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary layout of the GL call traces written by GLTrace (opengl/GLTrace.hpp) and read by tools/gl_replay.
+// Everything is little endian and made of 32-bit words:
+//
+//   file  := FileHeader frame*
+//   frame := FrameHeader call*          (FrameHeader::words words of calls follow the header)
+//   call  := CallHeader word*           (CallHeader::words words of arguments follow the header)
+//
+// Arguments are written in the order of the GL signature. 64-bit values (offsets, sizes) take two words, low word first.
+// Arrays of names are written as a count followed by the names. Blobs (shader source, buffer contents) are written as
+// their length in bytes followed by the bytes, padded to a whole word. Return values come last.
+namespace GLTrace {
+    constexpr uint32_t FileMagic = 0x54474c42; // "BLGT"
+    constexpr uint32_t FrameMagic = 0x454d5246; // "FRME"
+    constexpr uint32_t FormatVersion = 3;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+    };
+
+    struct FrameHeader {
+        uint32_t magic;
+        uint32_t index;
+        uint32_t words;
+        uint32_t calls;
+        // calls that didn't fit into the recording buffer, a replay of this frame is incomplete if this isn't 0
+        uint32_t droppedCalls;
+    };
+
+    struct CallHeader {
+        uint16_t op;
+        uint16_t words;
+    };
+
+#define GLTRACE_OPS(X) \
+    X(ActiveTexture)            /* texture */ \
+    X(AttachShader)             /* program, shader */ \
+    X(BindBuffer)               /* target, buffer */ \
+    X(BindBufferRange)          /* target, index, buffer, offset64, size64 */ \
+    X(BindFramebuffer)          /* target, framebuffer */ \
+    X(BindTexture)              /* target, texture */ \
+    X(BindVertexArray)          /* array */ \
+    X(BlitFramebuffer)          /* srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter */ \
+    X(BufferData)               /* target, size64, usage, blob (empty for NULL data) */ \
+    X(BufferSubData)            /* target, offset64, blob */ \
+    X(Clear)                    /* mask */ \
+    X(ClientWaitSync)           /* sync64, flags, timeout64 -> status */ \
+    X(CompileShader)            /* shader */ \
+    X(CreateProgram)            /* -> program */ \
+    X(CreateShader)             /* type -> shader */ \
+    X(DeleteBuffers)            /* n, buffers[n] */ \
+    X(DeleteFramebuffers)       /* n, framebuffers[n] */ \
+    X(DeleteShader)             /* shader */ \
+    X(DeleteSync)               /* sync64 */ \
+    X(DeleteTextures)           /* n, textures[n] */ \
+    X(DeleteVertexArrays)       /* n, arrays[n] */ \
+    X(Disable)                  /* cap */ \
+    X(DrawArrays)               /* mode, first, count */ \
+    X(EnableVertexAttribArray)  /* index */ \
+    X(FenceSync)                /* condition, flags -> sync64 */ \
+    X(FramebufferTexture2D)     /* target, attachment, textarget, texture, level */ \
+    X(GenBuffers)               /* n, buffers[n] */ \
+    X(GenFramebuffers)          /* n, framebuffers[n] */ \
+    X(GenTextures)              /* n, textures[n] */ \
+    X(GenVertexArrays)          /* n, arrays[n] */ \
+    X(GetUniformLocation)       /* program, blob name -> location */ \
+    X(LinkProgram)              /* program */ \
+    X(MapBufferRange)           /* target, offset64, length64, access (the mapped memory is not recorded) */ \
+    X(ReadPixels)               /* x, y, width, height, format, type, pixels64 (only reads into a pack buffer can be replayed) */ \
+    X(ShaderSource)             /* shader, blob (all strings concatenated) */ \
+    X(TexImage2D)               /* target, level, internalformat, width, height, border, format, type (pixels are not recorded) */ \
+    X(TexParameteri)            /* target, pname, param */ \
+    X(TexStorage2D)             /* target, levels, internalformat, width, height */ \
+    X(Uniform1f)                /* location, v0 */ \
+    X(Uniform1i)                /* location, v0 */ \
+    X(UnmapBuffer)              /* target */ \
+    X(UseProgram)               /* program */ \
+    X(VertexAttribPointer)      /* index, size, type, normalized, stride, pointer64 */ \
+    X(Viewport)                 /* x, y, width, height */
+
+    enum class Op : uint16_t {
+#define GLTRACE_OP_ENUM(name) name,
+        GLTRACE_OPS(GLTRACE_OP_ENUM)
+#undef GLTRACE_OP_ENUM
+        Count
+    };
+
+    constexpr const char* opName(Op op) {
+        switch (op) {
+#define GLTRACE_OP_NAME(name) case Op::name: return "gl" #name;
+            GLTRACE_OPS(GLTRACE_OP_NAME)
+#undef GLTRACE_OP_NAME
+            default: return "<unknown>";
+        }
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "GLTrace.hpp"
+#include "Shader.hpp"
+#include "UniformBuffer.hpp"
+
+#include <array>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+// Small render graph for the bloom pipeline.
+// Passes declare the resources they read and the single target they write, then compile() works out the rest:
+// passes that don't contribute to an output are dropped, the lifetime of every transient texture is computed and
+// transients whose lifetimes don't overlap share the same texture. execute() then only binds what changed between passes,
+// as long as the passes bind their program and uniform blocks through the Context.
+//
+// Passes run in the order they were added, so they must be added after the passes producing their inputs.
+class RenderGraph
+{
+public:
+    // handle to a virtual resource, only valid for the graph that created it
+    using Resource = uint32_t;
+
+    struct TextureDesc {
+        GLsizei width = 0;
+        GLsizei height = 0;
+        GLenum internalFormat = GL_RGBA16F;
+
+        bool operator==(TextureDesc const&) const = default;
+    };
+
+    class PassBuilder {
+    public:
+        void read(Resource resource);
+        // every pass renders into exactly one target
+        void write(Resource resource);
+        // only run the pass while *condition is true. Checked on every execute(), so it can change per frame
+        void runIf(bool const* condition);
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, size_t pass) : graph(graph), pass(pass) {}
+
+        RenderGraph& graph;
+        size_t pass;
+    };
+
+    class Context {
+    public:
+        // the texture currently backing a resource the pass reads
+        GLuint texture(Resource resource) const;
+        // bind a program or a uniform buffer range, unless an earlier pass of this execute() already did
+        void use(Shader& shader) const;
+        void bindRange(UniformBuffer const& buffer, GLuint binding, GLintptr offset, GLsizeiptr size) const;
+
+    private:
+        friend class RenderGraph;
+        explicit Context(RenderGraph const& graph) : graph(graph) {}
+
+        struct UniformRange {
+            GLuint buffer = 0;
+            GLintptr offset = 0;
+            GLsizeiptr size = 0;
+
+            bool operator==(UniformRange const&) const = default;
+        };
+
+        RenderGraph const& graph;
+        // what is bound before the first pass is unknown, 0 until a pass binds something
+        mutable GLuint boundProgram = 0;
+        mutable std::vector<UniformRange> boundRanges;
+    };
+
+    using Setup = std::function<void(PassBuilder&)>;
+    using Execute = std::function<void(Context const&)>;
+
+    // texture owned by the graph, allocated by compile() and possibly shared with other transients
+    Resource createTexture(std::string name, TextureDesc desc);
+    // texture owned by someone else, can only be read
+    Resource importTexture(std::string name, GLuint texture);
+    // framebuffer owned by someone else, e.g. the default one. Can only be written, with the viewport passed to execute()
+    Resource importFramebuffer(std::string name, GLuint framebuffer);
+
+    // passes that don't (indirectly) write an output are culled
+    void markOutput(Resource resource);
+    // keep the contents of a transient until the next execute(), e.g. so a disabled pass can reuse them.
+    // It only shares memory with transients that are written under the same runIf() condition as itself
+    void retain(Resource resource);
+
+    void addPass(std::string name, Setup const& setup, Execute execute);
+
+    // culls passes, computes lifetimes and allocates the transient textures. Throws if the graph is malformed
+    void compile();
+    // runs every pass that survived compile() and whose condition holds.
+    // `viewport` is the one the caller has bound, it is kept for imported framebuffers and restored afterwards
+    void execute(GLint const (&viewport)[4]);
+    // deletes the textures and framebuffers allocated by compile()
+    void release();
+
+private:
+    enum class ResourceKind {
+        Transient,
+        ImportedTexture,
+        ImportedFramebuffer,
+    };
+
+    struct ResourceNode {
+        std::string name;
+        ResourceKind kind;
+        TextureDesc desc;
+        GLuint texture = 0;
+        GLuint framebuffer = 0;
+        bool output = false;
+        bool retained = false;
+
+        // filled by compile()
+        int physical = -1;
+        size_t firstUse = 0;
+        size_t lastUse = 0;
+        bool const* writeCondition = nullptr;
+    };
+
+    struct PassNode {
+        std::string name;
+        std::vector<Resource> reads;
+        std::vector<Resource> writes;
+        bool const* condition = nullptr;
+        Execute execute;
+        bool culled = true;
+    };
+
+    // a real texture and its framebuffer, shared by every transient assigned to it
+    struct PhysicalTexture {
+        TextureDesc desc;
+        GLuint texture = 0;
+        GLuint framebuffer = 0;
+        std::vector<Resource> resources;
+    };
+
+    std::vector<ResourceNode> resources;
+    std::vector<PassNode> passes;
+    std::vector<PhysicalTexture> physicalTextures;
+    // passes that survived culling, in execution order
+    std::vector<size_t> schedule;
+
+    void cullPasses();
+    void computeLifetimes();
+    bool canShare(PhysicalTexture const& physical, ResourceNode const& resource) const;
+    void allocate();
+};
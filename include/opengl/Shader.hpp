@@ -2,19 +2,41 @@
 
 #pragma once
 
-#include <GLES3/gl3.h> // include glad to get all the required OpenGL headers
+#include "GLTrace.hpp" // the GLES headers, plus the call tracing hooks when built with BLOOM_GL_TRACE
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
 
 
+// Typed handle to a uniform location, resolved once after the program is linked
+template<typename T>
+struct Uniform {
+    GLint location = -1;
+};
+
+// Sampler uniform that has been bound to a fixed texture unit after linking
+template<GLenum Target>
+struct Sampler {
+    GLint location = -1;
+    GLint unit = 0;
+
+    // bind a texture to this sampler's unit
+    void bind(GLuint texture) const {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(Target, texture);
+    }
+};
+
 class Shader
 {
 public:
     // the program ID
     unsigned int Shader_ID;
+    // active uniform locations, queried once at link time
+    std::unordered_map<std::string, GLint> uniformLocations;
 
     // constructor reads and builds the shader
     Shader() = default;
@@ -23,8 +45,30 @@ public:
     static Shader fromFile(const char* vextexPath, const char* fragmentPath);
     // use/activate the shader
     void use();
+
     // utility uniform functions
-    void setBool(const std::string &name, bool value) const;
-    void setInt(const std::string &name, int value) const;
-    void setFloat(const std::string &name, float value) const;
+    void set(Uniform<bool> uniform, bool value) const;
+    void set(Uniform<int> uniform, int value) const;
+    void set(Uniform<float> uniform, float value) const;
+
+protected:
+    // look up a cached uniform location.
+    // Only the generated program structs (include/shaders/*_program.hpp) should call these, once after linking
+    GLint location(const std::string &name) const;
+
+    template<typename T>
+    Uniform<T> uniform(const std::string &name) const {
+        return {location(name)};
+    }
+
+    // bind a sampler to a texture unit. The program must be in use
+    template<GLenum Target>
+    Sampler<Target> sampler(const std::string &name, GLint unit) const {
+        Sampler<Target> result{location(name), unit};
+        set(Uniform<int>{result.location}, unit);
+        return result;
+    }
+
+private:
+    void cacheUniformLocations();
 };
@@ -4,22 +4,31 @@
 
 #include "shaders/bloom_fs.glsl.hpp"
 #include "shaders/bloom_vs.glsl.hpp"
+#include "shaders/bloom_program.hpp"
 
 #include "shaders/final_process_fs.glsl.hpp"
 #include "shaders/final_process_vs.glsl.hpp"
+#include "shaders/final_process_program.hpp"
 
 #include "shaders/gaussian_fs.glsl.hpp"
 #include "shaders/gaussian_vs.glsl.hpp"
+#include "shaders/gaussian_program.hpp"
 
-#define shader_macro(s) \
-static Shader s() { \
+#include "shaders/signature_fs.glsl.hpp"
+#include "shaders/signature_vs.glsl.hpp"
+#include "shaders/signature_program.hpp"
+
+#define shader_macro(s, program) \
+static program s() { \
     return {s##_vs_glsl, s##_fs_glsl}; \
 }
 
 namespace Shaders {
-    shader_macro(gaussian)
+    shader_macro(gaussian, GaussianProgram)
+
+    shader_macro(final_process, FinalProcessProgram)
 
-    shader_macro(final_process)
+    shader_macro(bloom, BloomProgram)
 
-    shader_macro(bloom)
+    shader_macro(signature, SignatureProgram)
 }
\ No newline at end of file
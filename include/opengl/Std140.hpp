@@ -0,0 +1,10 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+// std140 rounds every array element up to the size of a vec4.
+// Generated uniform block structs (include/shaders/uniform_blocks.hpp) use this for their array members.
+template<typename T>
+struct alignas(16) Std140Element {
+    T value;
+};
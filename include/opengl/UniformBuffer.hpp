@@ -0,0 +1,35 @@
+#pragma once
+
+#include "GLTrace.hpp"
+
+
+// Thin wrapper around a GL_UNIFORM_BUFFER.
+// Used for std140 blocks that are written once per frame and then bound (per range) for each pass.
+class UniformBuffer
+{
+public:
+    // the buffer ID
+    unsigned int Buffer_ID = 0;
+    GLsizeiptr Size = 0;
+
+    UniformBuffer() = default;
+    explicit UniformBuffer(GLsizeiptr size);
+
+    // upload a block at the given byte offset
+    void update(GLintptr offset, GLsizeiptr size, const void* data) const;
+
+    template<typename T>
+    void update(GLintptr offset, T const& block) const {
+        update(offset, sizeof(T), &block);
+    }
+
+    // bind part of the buffer to a uniform block binding point
+    void bindRange(GLuint binding, GLintptr offset, GLsizeiptr size) const;
+
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, needed for every offset passed to bindRange
+    static GLint offsetAlignment();
+
+    static constexpr GLintptr align(GLintptr offset, GLintptr alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+};
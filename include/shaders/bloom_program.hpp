@@ -0,0 +1,17 @@
+// Generated by compile_shaders.py from bloom_vs.glsl and bloom_fs.glsl, do not edit.
+#pragma once
+
+#include "opengl/Shader.hpp"
+#include "shaders/uniform_blocks.hpp"
+
+namespace Shaders {
+    struct BloomProgram : public Shader {
+        Sampler<GL_TEXTURE_2D> cameraTexture;
+
+        BloomProgram() = default;
+        BloomProgram(const char* vertexCode, const char* fragmentCode) : Shader(vertexCode, fragmentCode) {
+            use();
+            cameraTexture = sampler<GL_TEXTURE_2D>("cameraTexture", 0);
+        }
+    };
+}
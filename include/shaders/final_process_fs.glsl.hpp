@@ -9,7 +9,12 @@ constexpr const char* final_process_fs_glsl = "#version 310 es\n"
 "\n"
 "uniform sampler2D scene;\n"
 "uniform sampler2D bloomBlur;\n"
-"uniform float exposure;\n"
+"\n"
+"layout (std140, binding = 0) uniform BloomFrame {\n"
+"    float weight[5];\n"
+"    highp vec2 texelSize;\n"
+"    float exposure;\n"
+"};\n"
 "\n"
 "void main()\n"
 "{\n"
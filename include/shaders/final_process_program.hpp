@@ -0,0 +1,22 @@
+// Generated by compile_shaders.py from final_process_vs.glsl and final_process_fs.glsl, do not edit.
+#pragma once
+
+#include "opengl/Shader.hpp"
+#include "shaders/uniform_blocks.hpp"
+
+namespace Shaders {
+    struct FinalProcessProgram : public Shader {
+        // uniform blocks, bound through their layout binding
+        using BloomFrame = Blocks::BloomFrame;
+
+        Sampler<GL_TEXTURE_2D> scene;
+        Sampler<GL_TEXTURE_2D> bloomBlur;
+
+        FinalProcessProgram() = default;
+        FinalProcessProgram(const char* vertexCode, const char* fragmentCode) : Shader(vertexCode, fragmentCode) {
+            use();
+            scene = sampler<GL_TEXTURE_2D>("scene", 0);
+            bloomBlur = sampler<GL_TEXTURE_2D>("bloomBlur", 1);
+        }
+    };
+}
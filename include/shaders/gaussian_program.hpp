@@ -0,0 +1,21 @@
+// Generated by compile_shaders.py from gaussian_vs.glsl and gaussian_fs.glsl, do not edit.
+#pragma once
+
+#include "opengl/Shader.hpp"
+#include "shaders/uniform_blocks.hpp"
+
+namespace Shaders {
+    struct GaussianProgram : public Shader {
+        // uniform blocks, bound through their layout binding
+        using BloomFrame = Blocks::BloomFrame;
+        using BlurPass = Blocks::BlurPass;
+
+        Sampler<GL_TEXTURE_2D> image;
+
+        GaussianProgram() = default;
+        GaussianProgram(const char* vertexCode, const char* fragmentCode) : Shader(vertexCode, fragmentCode) {
+            use();
+            image = sampler<GL_TEXTURE_2D>("image", 0);
+        }
+    };
+}
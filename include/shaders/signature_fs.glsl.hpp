@@ -0,0 +1,42 @@
+
+constexpr const char* signature_fs_glsl = "#version 310 es\n"
+"\n"
+"precision mediump float;\n"
+"\n"
+"// Tiny luminance signature of the scene, used to detect frames that didn't change.\n"
+"// r: luminance of this cell\n"
+"// g: difference to the previous frame's signature\n"
+"// b: difference to the signature of the frame the cached blur was computed from\n"
+"\n"
+"uniform sampler2D scene;\n"
+"uniform sampler2D previous;\n"
+"uniform sampler2D reference;\n"
+"\n"
+"layout (location = 0) in vec2 texCoords;\n"
+"layout (location = 0) out vec4 Signature;\n"
+"\n"
+"void main()\n"
+"{\n"
+"    // average a 4x4 grid of taps over the cell, so small changes still show up\n"
+"    vec2 cellSize = 1.0 / vec2(textureSize(previous, 0));\n"
+"    vec3 color = vec3(0.0);\n"
+"    for(int y = 0; y < 4; ++y)\n"
+"    {\n"
+"        for(int x = 0; x < 4; ++x)\n"
+"        {\n"
+"            vec2 tap = (vec2(float(x), float(y)) + 0.5) / 4.0 - 0.5;\n"
+"            color += texture(scene, texCoords + tap * cellSize).rgb;\n"
+"        }\n"
+"    }\n"
+"    color /= 16.0;\n"
+"\n"
+"    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));\n"
+"    // squash HDR values into [0, 1) so they fit the 8 bit signature\n"
+"    luminance = luminance / (1.0 + luminance);\n"
+"\n"
+"    ivec2 cell = ivec2(gl_FragCoord.xy);\n"
+"    float previousLuminance = texelFetch(previous, cell, 0).r;\n"
+"    float referenceLuminance = texelFetch(reference, cell, 0).r;\n"
+"    Signature = vec4(luminance, abs(luminance - previousLuminance), abs(luminance - referenceLuminance), 1.0);\n"
+"}\n"
+;
@@ -0,0 +1,21 @@
+// Generated by compile_shaders.py from signature_vs.glsl and signature_fs.glsl, do not edit.
+#pragma once
+
+#include "opengl/Shader.hpp"
+#include "shaders/uniform_blocks.hpp"
+
+namespace Shaders {
+    struct SignatureProgram : public Shader {
+        Sampler<GL_TEXTURE_2D> scene;
+        Sampler<GL_TEXTURE_2D> previous;
+        Sampler<GL_TEXTURE_2D> reference;
+
+        SignatureProgram() = default;
+        SignatureProgram(const char* vertexCode, const char* fragmentCode) : Shader(vertexCode, fragmentCode) {
+            use();
+            scene = sampler<GL_TEXTURE_2D>("scene", 0);
+            previous = sampler<GL_TEXTURE_2D>("previous", 1);
+            reference = sampler<GL_TEXTURE_2D>("reference", 2);
+        }
+    };
+}
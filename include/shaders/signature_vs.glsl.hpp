@@ -0,0 +1,19 @@
+
+constexpr const char* signature_vs_glsl = "#version 310 es\n"
+"\n"
+"// Fullscreen triangle strip without any vertex buffer, see bloom_vs.glsl\n"
+"\n"
+"layout (location = 0) out vec2 texCoords;\n"
+"\n"
+"const vec2 pos[4]=\n"
+"vec2[4](vec2(-1.0, 1.0),\n"
+"vec2(-1.0,-1.0),\n"
+"vec2( 1.0, 1.0),\n"
+"vec2( 1.0,-1.0));\n"
+"\n"
+"void main()\n"
+"{\n"
+"    texCoords = 0.5 * pos[gl_VertexID] + vec2(0.5);\n"
+"    gl_Position = vec4(pos[gl_VertexID], 0.0, 1.0);\n"
+"}\n"
+;
@@ -0,0 +1,33 @@
+// Generated by compile_shaders.py, do not edit.
+#pragma once
+
+#include "opengl/Std140.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Shaders::Blocks {
+    // uniform BloomFrame, std140
+    struct BloomFrame {
+        static constexpr GLuint binding = 0;
+
+        Std140Element<float> weight[5];
+        float texelSize[2];
+        float exposure;
+        uint8_t _pad0[4];
+    };
+    static_assert(sizeof(BloomFrame) == 96);
+    static_assert(offsetof(BloomFrame, weight) == 0);
+    static_assert(offsetof(BloomFrame, texelSize) == 80);
+    static_assert(offsetof(BloomFrame, exposure) == 88);
+
+    // uniform BlurPass, std140
+    struct BlurPass {
+        static constexpr GLuint binding = 1;
+
+        float direction[2];
+        uint8_t _pad0[8];
+    };
+    static_assert(sizeof(BlurPass) == 16);
+    static_assert(offsetof(BlurPass, direction) == 0);
+}
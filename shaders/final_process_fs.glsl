@@ -8,7 +8,12 @@ in vec2 TexCoords;
 
 uniform sampler2D scene;
 uniform sampler2D bloomBlur;
-uniform float exposure;
+
+layout (std140, binding = 0) uniform BloomFrame {
+    float weight[5];
+    highp vec2 texelSize;
+    float exposure;
+};
 
 void main()
 {
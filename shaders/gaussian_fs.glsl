@@ -8,33 +8,26 @@ in vec2 TexCoords;
 
 uniform sampler2D image;
 
-uniform bool horizontal;
-float weight[5] = float[] (0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216);
+layout (std140, binding = 0) uniform BloomFrame {
+    float weight[5];
+    highp vec2 texelSize;
+    float exposure;
+};
+
+layout (std140, binding = 1) uniform BlurPass {
+    // (1, 0) for the horizontal pass, (0, 1) for the vertical pass
+    vec2 direction;
+};
 
 void main()
 {
-    ivec2 texSize = textureSize(image, 0); // gets size of single texel
-    vec2 tex_offset = vec2(1.0, 1.0);
-    tex_offset.x /= float(texSize.x);
-    tex_offset.y /= float(texSize.y);
-
+    highp vec2 tex_offset = texelSize * direction; // size of a single texel along the blur direction
 
     vec3 result = texture(image, TexCoords).rgb * weight[0]; // current fragment's contribution
-    if(horizontal)
-    {
-        for(int i = 1; i < 5; ++i)
-        {
-            result += texture(image, TexCoords + vec2(tex_offset.x * float(i), 0.0)).rgb * weight[i];
-            result += texture(image, TexCoords - vec2(tex_offset.x * float(i), 0.0)).rgb * weight[i];
-        }
-    }
-    else
+    for(int i = 1; i < 5; ++i)
     {
-        for(int i = 1; i < 5; ++i)
-        {
-            result += texture(image, TexCoords + vec2(0.0, tex_offset.y * float(i))).rgb * weight[i];
-            result += texture(image, TexCoords - vec2(0.0, tex_offset.y * float(i))).rgb * weight[i];
-        }
+        result += texture(image, TexCoords + tex_offset * float(i)).rgb * weight[i];
+        result += texture(image, TexCoords - tex_offset * float(i)).rgb * weight[i];
     }
     FragColor = vec4(result, 1.0);
 }
\ No newline at end of file
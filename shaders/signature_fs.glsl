@@ -0,0 +1,40 @@
+#version 310 es
+
+precision mediump float;
+
+// Tiny luminance signature of the scene, used to detect frames that didn't change.
+// r: luminance of this cell
+// g: difference to the previous frame's signature
+// b: difference to the signature of the frame the cached blur was computed from
+
+uniform sampler2D scene;
+uniform sampler2D previous;
+uniform sampler2D reference;
+
+layout (location = 0) in vec2 texCoords;
+layout (location = 0) out vec4 Signature;
+
+void main()
+{
+    // average a 4x4 grid of taps over the cell, so small changes still show up
+    vec2 cellSize = 1.0 / vec2(textureSize(previous, 0));
+    vec3 color = vec3(0.0);
+    for(int y = 0; y < 4; ++y)
+    {
+        for(int x = 0; x < 4; ++x)
+        {
+            vec2 tap = (vec2(float(x), float(y)) + 0.5) / 4.0 - 0.5;
+            color += texture(scene, texCoords + tap * cellSize).rgb;
+        }
+    }
+    color /= 16.0;
+
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    // squash HDR values into [0, 1) so they fit the 8 bit signature
+    luminance = luminance / (1.0 + luminance);
+
+    ivec2 cell = ivec2(gl_FragCoord.xy);
+    float previousLuminance = texelFetch(previous, cell, 0).r;
+    float referenceLuminance = texelFetch(reference, cell, 0).r;
+    Signature = vec4(luminance, abs(luminance - previousLuminance), abs(luminance - referenceLuminance), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 310 es
+
+// Fullscreen triangle strip without any vertex buffer, see bloom_vs.glsl
+
+layout (location = 0) out vec2 texCoords;
+
+const vec2 pos[4]=
+vec2[4](vec2(-1.0, 1.0),
+vec2(-1.0,-1.0),
+vec2( 1.0, 1.0),
+vec2( 1.0,-1.0));
+
+void main()
+{
+    texCoords = 0.5 * pos[gl_VertexID] + vec2(0.5);
+    gl_Position = vec4(pos[gl_VertexID], 0.0, 1.0);
+}
\ No newline at end of file
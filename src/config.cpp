@@ -0,0 +1,176 @@
+#include "config.hpp"
+#include "main.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BloomConfig {
+    namespace {
+        constexpr auto BlurPassesKey = "blurPasses";
+        constexpr auto ExposureKey = "exposure";
+        constexpr auto ChangeThresholdKey = "changeThreshold";
+        constexpr auto StaticFramesBeforeReuseKey = "staticFramesBeforeReuse";
+
+        struct Task {
+            std::function<void(BloomSettings&)> apply;
+            // only changes made through update() are saved, a reload just re-reads the file
+            bool save;
+        };
+
+        // Shared with the config thread. Never destroyed, the thread is still waiting on it when the process exits
+        struct Worker {
+            std::vector<Task> tasks;
+            std::mutex mutex;
+            std::condition_variable changed;
+        };
+        Worker* worker = nullptr;
+
+        // Published snapshots are never freed, a reader may still be using an old one.
+        // Settings only change when the user edits them, so this doesn't add up to much
+        std::atomic<BloomSettings const*> snapshot = nullptr;
+        std::atomic<uint32_t> pendingChanges = None;
+
+        BloomSettings read(ConfigDocument const& config) {
+            BloomSettings settings;
+            if (!config.IsObject()) return settings;
+
+            auto readInt = [&](const char* key, int& value, int min, int max) {
+                auto it = config.FindMember(key);
+                if (it != config.MemberEnd() && it->value.IsInt()) value = std::clamp(it->value.GetInt(), min, max);
+            };
+            auto readFloat = [&](const char* key, float& value, float min, float max) {
+                auto it = config.FindMember(key);
+                if (it != config.MemberEnd() && it->value.IsNumber()) value = std::clamp(it->value.GetFloat(), min, max);
+            };
+
+            readInt(BlurPassesKey, settings.blurPasses, 0, 64);
+            readFloat(ExposureKey, settings.exposure, 0.0f, 16.0f);
+            readInt(ChangeThresholdKey, settings.changeThreshold, 0, 255);
+            readInt(StaticFramesBeforeReuseKey, settings.staticFramesBeforeReuse, 1, 600);
+            return settings;
+        }
+
+        bool hasAllKeys(ConfigDocument const& config) {
+            return config.IsObject() && config.HasMember(BlurPassesKey) && config.HasMember(ExposureKey) &&
+                   config.HasMember(ChangeThresholdKey) && config.HasMember(StaticFramesBeforeReuseKey);
+        }
+
+        // also adds missing keys, so every setting shows up in the file
+        void write(ConfigDocument& config, BloomSettings const& settings) {
+            if (!config.IsObject()) config.SetObject();
+
+            auto set = [&](const char* key, auto value) {
+                auto it = config.FindMember(key);
+                if (it != config.MemberEnd()) {
+                    it->value = value;
+                } else {
+                    config.AddMember(rapidjson::StringRef(key), value, config.GetAllocator());
+                }
+            };
+
+            set(BlurPassesKey, settings.blurPasses);
+            set(ExposureKey, settings.exposure);
+            set(ChangeThresholdKey, settings.changeThreshold);
+            set(StaticFramesBeforeReuseKey, settings.staticFramesBeforeReuse);
+        }
+
+        uint32_t diff(BloomSettings const& a, BloomSettings const& b) {
+            uint32_t changes = None;
+            if (a.blurPasses != b.blurPasses) changes |= BlurPasses;
+            if (a.exposure != b.exposure) changes |= Exposure;
+            if (a.changeThreshold != b.changeThreshold || a.staticFramesBeforeReuse != b.staticFramesBeforeReuse)
+                changes |= ChangeDetection;
+            return changes;
+        }
+
+        // only called by the config thread, after load() published the first snapshot
+        void publish(BloomSettings const& settings) {
+            auto const changes = diff(current(), settings);
+            if (changes == None) return;
+
+            snapshot.store(new BloomSettings(settings), std::memory_order_release);
+            pendingChanges.fetch_or(changes, std::memory_order_release);
+            PLogger.fmtLog<Paper::LogLevel::INF>("Settings changed ({:#x})", changes);
+        }
+
+        void workerLoop() {
+            std::vector<Task> tasks;
+            while (true) {
+                {
+                    std::unique_lock lock(worker->mutex);
+                    worker->changed.wait(lock, [] { return !worker->tasks.empty(); });
+                    std::swap(tasks, worker->tasks);
+                }
+
+                // everything queued so far ends up in a single snapshot
+                BloomSettings settings = current();
+                bool save = false;
+                for (auto const& task : tasks) {
+                    task.apply(settings);
+                    save |= task.save;
+                }
+                tasks.clear();
+
+                if (save && diff(current(), settings) != None) {
+                    write(getConfig().config, settings);
+                    getConfig().Write();
+                }
+                publish(settings);
+            }
+        }
+
+        void enqueue(Task task) {
+            {
+                std::lock_guard lock(worker->mutex);
+                worker->tasks.push_back(std::move(task));
+            }
+            worker->changed.notify_one();
+        }
+    }
+
+    void load() {
+        if (worker != nullptr) return;
+
+        auto& config = getConfig();
+        config.Load();
+        auto const settings = read(config.config);
+        // only fill in missing keys, a file that isn't valid is left for the user to fix
+        if (!config.config.IsObject()) {
+            PLogger.fmtLog<Paper::LogLevel::WRN>("Config file is not a JSON object, using the default settings");
+        } else if (!hasAllKeys(config.config)) {
+            write(config.config, settings);
+            config.Write();
+        }
+        snapshot.store(new BloomSettings(settings), std::memory_order_release);
+
+        worker = new Worker();
+        std::thread(workerLoop).detach();
+    }
+
+    BloomSettings const& current() {
+        return *snapshot.load(std::memory_order_acquire);
+    }
+
+    uint32_t takeChanges() {
+        return pendingChanges.exchange(None, std::memory_order_acquire);
+    }
+
+    void reload() {
+        enqueue({[](BloomSettings& settings) {
+            getConfig().Reload();
+            if (!getConfig().config.IsObject()) {
+                PLogger.fmtLog<Paper::LogLevel::WRN>("Config file is not a JSON object, keeping the current settings");
+                return;
+            }
+            settings = read(getConfig().config);
+        }, false});
+    }
+
+    void update(std::function<void(BloomSettings&)> change) {
+        enqueue({std::move(change), true});
+    }
+}
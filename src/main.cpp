@@ -1,10 +1,15 @@
 #include "main.hpp"
+#include "config.hpp"
 #include "opengl/Shader.hpp"
 #include "opengl/Shaders.hpp"
+#include "opengl/UniformBuffer.hpp"
+#include "opengl/ChangeDetector.hpp"
+#include "opengl/RenderGraph.hpp"
 
 #include "coro.hpp"
 
 #include "UnityEngine/GameObject.hpp"
+#include "UnityEngine/Object.hpp"
 #include "UnityEngine/SceneManagement/SceneManager.hpp"
 #include "UnityEngine/SceneManagement/Scene.hpp"
 #include "UnityEngine/SceneManagement/LoadSceneMode.hpp"
@@ -20,19 +25,19 @@
 #include "GlobalNamespace/BloomPrePassBloomTextureEffectSO.hpp"
 #include "GlobalNamespace/BloomPrePassEffectContainerSO.hpp"
 
+#include "beatsaber-hook/shared/utils/typedefs-wrappers.hpp"
+
 #include "custom-types/shared/coroutine.hpp"
 #include "custom-types/shared/register.hpp"
 
 
-#include <GLES3/gl32.h>
-#include <GLES3/gl3ext.h>
+#include "opengl/GLTrace.hpp"
 
 static ModInfo modInfo; // Stores the ID and version of our mod, and is sent to the modloader upon startup
 
-// Loads the config from disk using our modInfo, then returns it for use
+// Returns the config using our modInfo. Only BloomConfig touches it, read settings through BloomConfig::current() instead
 Configuration& getConfig() {
     static Configuration config(modInfo);
-    config.Load();
     return config;
 }
 
@@ -78,6 +83,13 @@ extern "C" void dispose(int event_id) {
     lock.unlock();
 }
 
+// Called on the render thread, while the main thread may be adding tasks
+static std::shared_ptr<Task> findTask(int event_id) {
+    std::shared_lock lock(tasks_mutex);
+    auto it = tasks.find(event_id);
+    return it != tasks.end() ? it->second : nullptr;
+}
+
 // renderQuad() renders a 1x1 XY quad in NDC
 // -----------------------------------------
 unsigned int quadVAO = 0;
@@ -141,27 +153,161 @@ void BlitShader(GLuint cameraSrcTexture, Shader& shader)
     glDeleteVertexArrays(1, &quadVertices);
 }
 
-static Shader shaderBloom;
-static Shader shaderBlur;
-static Shader shaderBloomFinal;
+static Shaders::BloomProgram shaderBloom;
+static Shaders::GaussianProgram shaderBlur;
+static Shaders::FinalProcessProgram shaderBloomFinal;
+
+using BloomFrame = Shaders::Blocks::BloomFrame;
+using BlurPass = Shaders::Blocks::BlurPass;
 
-unsigned int pingpongFBO[2];
-unsigned int pingpongColorbuffers[2];
 unsigned int colorBuffers[2];
 
+// BloomFrame at offset 0, followed by one BlurPass block per direction (indexed by `horizontal`)
+static UniformBuffer bloomUniforms;
+static GLintptr blurPassOffsets[2];
+static int bloomWidth = 0, bloomHeight = 0;
+// the viewport Unity has bound, read at the start of every frame and restored after our passes
+static GLint gameViewport[4] = {};
+// size asked for by the last Initialize/Rebind, zero while nothing fills in the Task size
+static int requestedWidth = 0, requestedHeight = 0;
+
+// skips the blur on frames that look like the one it was last computed for
+static ChangeDetector changeDetector;
+
+// blur and composite passes, rebuilt whenever the targets are recreated
+static RenderGraph bloomGraph;
+// false while the last build failed, bloom stays off until the next rebuild succeeds
+static bool bloomGraphBuilt = false;
+static bool recomputeBlur = true;
+
+static void buildBloomGraph(int width, int height, int blurPasses) {
+    bloomGraph.release();
+    bloomGraph = RenderGraph();
+
+    RenderGraph::TextureDesc const desc{width, height, GL_RGBA16F};
+    auto const scene = bloomGraph.importTexture("scene", colorBuffers[0]);
+    auto const bright = bloomGraph.importTexture("bright", colorBuffers[1]);
+    auto const backbuffer = bloomGraph.importFramebuffer("backbuffer", 0);
+
+    // blur bright fragments with two-pass Gaussian Blur. Every pass gets its own texture, the graph aliases them onto two
+    auto blurred = bright;
+    bool horizontal = true;
+    for (int i = 0; i < blurPasses; i++) {
+        auto const input = blurred;
+        auto const output = bloomGraph.createTexture("blur" + std::to_string(i), desc);
+        bloomGraph.addPass("blur" + std::to_string(i), [&](RenderGraph::PassBuilder& pass) {
+            pass.read(input);
+            pass.write(output);
+            pass.runIf(&recomputeBlur);
+        }, [input, horizontal](RenderGraph::Context const& context) {
+            context.bindRange(bloomUniforms, BlurPass::binding, blurPassOffsets[horizontal], sizeof(BlurPass));
+            context.use(shaderBlur);
+            shaderBlur.image.bind(context.texture(input));
+            renderQuad();
+        });
+        blurred = output;
+        horizontal = !horizontal;
+    }
+    // reused on frames the change detector considers static
+    bloomGraph.retain(blurred);
+
+    // render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
+    bloomGraph.addPass("composite", [&](RenderGraph::PassBuilder& pass) {
+        pass.read(scene);
+        pass.read(blurred);
+        pass.write(backbuffer);
+    }, [scene, blurred](RenderGraph::Context const& context) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        context.use(shaderBloomFinal);
+        shaderBloomFinal.scene.bind(context.texture(scene));
+        shaderBloomFinal.bloomBlur.bind(context.texture(blurred));
+        renderQuad();
+    });
+    bloomGraph.markOutput(backbuffer);
+
+    // this runs on Unity's render thread, nothing up the stack would catch it
+    try {
+        bloomGraph.compile();
+        bloomGraphBuilt = true;
+    } catch (std::exception const& e) {
+        PLogger.fmtLog<Paper::LogLevel::ERR>("Unable to build the bloom graph, disabling bloom: {}", e.what());
+        bloomGraph.release();
+        bloomGraph = RenderGraph();
+        bloomGraphBuilt = false;
+    }
+}
+
+static void configureChangeDetector(BloomSettings const& settings) {
+    changeDetector.Threshold = static_cast<uint8_t>(settings.changeThreshold);
+    changeDetector.StaticFramesBeforeReuse = settings.staticFramesBeforeReuse;
+}
+
 GLint drawFboId = 0, readFboId = 0;
 
+// Nothing fills in the Task size yet, so fall back to the viewport Unity renders with
+static std::pair<int, int> targetSize() {
+    if (requestedWidth > 0 && requestedHeight > 0) return {requestedWidth, requestedHeight};
+    return {gameViewport[2], gameViewport[3]};
+}
+
+// (re)creates everything that depends on the target size
+static void bindTargets(int width, int height) {
+    bloomWidth = width;
+    bloomHeight = height;
+
+    // nothing to render into, bloomshader_Apply() skips the frame until a rebind with a real size
+    if (width <= 0 || height <= 0) {
+        PLogger.fmtLog<Paper::LogLevel::WRN>("Bloom targets have no size ({}x{}), disabling bloom", width, height);
+        bloomGraph.release();
+        bloomGraph = RenderGraph();
+        bloomGraphBuilt = false;
+        return;
+    }
+
+    // create 2 floating point color buffers (1 for normal rendering, other for brightness threshold values)
+    if (colorBuffers[0] != 0) {
+        glDeleteTextures(2, colorBuffers);
+    }
+    glGenTextures(2, colorBuffers);
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // attach texture to framebuffer
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // everything is rebuilt from the latest settings, so earlier changes don't matter anymore
+    BloomConfig::takeChanges();
+    auto const& settings = BloomConfig::current();
+    buildBloomGraph(width, height, settings.blurPasses);
+    configureChangeDetector(settings);
+
+    // the cached blur belonged to the old targets
+    changeDetector.invalidate();
+}
+
 extern "C" void bloomshader_Initialize(int eventId) {
-    auto task = tasks[eventId];
+    auto task = findTask(eventId);
+    if (task == nullptr) {
+        PLogger.fmtLog<Paper::LogLevel::ERR>("Unknown event {} for initialize", eventId);
+        return;
+    }
 
-    auto const SCR_WIDTH = task->width;
-    auto const SCR_HEIGHT = task->height;
+    // no-op unless built with BLOOM_GL_TRACE
+    GLTrace::start("/sdcard/Android/data/com.beatgames.beatsaber/files/logs/bloom_shader.gltrace");
 
     try {
         static auto lazyInitialize = []() {
             shaderBloom = Shaders::bloom();
             shaderBlur = Shaders::gaussian();
             shaderBloomFinal = Shaders::final_process();
+            changeDetector.initialize();
             return 0;
         }();
     } catch (...) {
@@ -172,48 +318,47 @@ extern "C" void bloomshader_Initialize(int eventId) {
     // EXPENSIVE
     glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFboId);
     glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFboId);
+    glGetIntegerv(GL_VIEWPORT, gameViewport);
 
-
-    // create 2 floating point color buffers (1 for normal rendering, other for brightness threshold values)
-    glGenTextures(2, colorBuffers);
-    for (unsigned int i = 0; i < 2; i++)
-    {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // attach texture to framebuffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
+    // uniform buffer for the per-frame and per-pass parameters
+    // --------------------
+    if (bloomUniforms.Buffer_ID == 0) {
+        auto const alignment = UniformBuffer::offsetAlignment();
+        blurPassOffsets[0] = UniformBuffer::align(sizeof(BloomFrame), alignment);
+        blurPassOffsets[1] = UniformBuffer::align(blurPassOffsets[0] + sizeof(BlurPass), alignment);
+        bloomUniforms = UniformBuffer(blurPassOffsets[1] + sizeof(BlurPass));
+
+        // the blur directions never change, so only upload them once
+        bloomUniforms.update(blurPassOffsets[0], BlurPass{{0.0f, 1.0f}});
+        bloomUniforms.update(blurPassOffsets[1], BlurPass{{1.0f, 0.0f}});
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    // ping-pong-framebuffer for blurring
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorbuffers);
-    for (unsigned int i = 0; i < 2; i++)
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
-        // also check if framebuffers are complete (no need for depth buffer)
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            PLogger.fmtLog<Paper::LogLevel::INF>("Framebuffer not complete!");
-    }
+    requestedWidth = task->width;
+    requestedHeight = task->height;
+    auto const [SCR_WIDTH, SCR_HEIGHT] = targetSize();
+    bindTargets(SCR_WIDTH, SCR_HEIGHT);
 
-    // shader configuration
-    // --------------------
-    shaderBlur.use();
-    shaderBlur.setInt("image", 0);
-    shaderBloomFinal.use();
-    shaderBloomFinal.setInt("scene", 0);
-    shaderBloomFinal.setInt("bloomBlur", 1);
+    dispose(eventId);
+}
+
+// Called on scene loads. Shaders, buffers and the render graph are kept, only the targets are recreated if their size changed
+extern "C" void bloomshader_Rebind(int eventId) {
+    auto task = findTask(eventId);
+    if (task == nullptr) {
+        PLogger.fmtLog<Paper::LogLevel::ERR>("Unknown event {} for rebind", eventId);
+        return;
+    }
+    glGetIntegerv(GL_VIEWPORT, gameViewport);
+
+    requestedWidth = task->width;
+    requestedHeight = task->height;
+    auto const [width, height] = targetSize();
+    if (width != bloomWidth || height != bloomHeight) {
+        bindTargets(width, height);
+    } else {
+        // nothing the cached blur was computed from is on screen anymore
+        changeDetector.invalidate();
+    }
 
     dispose(eventId);
 }
@@ -260,34 +405,59 @@ void bloomshader_Apply(int eventId) {
 //    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    // 2. blur bright fragments with two-pass Gaussian Blur
+    // Unity can change the viewport between frames, e.g. with the render scale, so don't rely on the one from the last rebind.
+    // Targets sized after the viewport follow it
+    glGetIntegerv(GL_VIEWPORT, gameViewport);
+    auto const [width, height] = targetSize();
+    if (width != bloomWidth || height != bloomHeight) {
+        bindTargets(width, height);
+    }
+
+    if (bloomWidth <= 0 || bloomHeight <= 0) {
+        GLTrace::endFrame();
+        return;
+    }
+
+    // 0. pick up settings changed since the last frame, only rebuilding what depends on them.
+    // The exposure is uploaded every frame anyway
     // --------------------------------------------------
-    bool horizontal = true, first_iteration = true;
-    unsigned int amount = 10;
-    shaderBlur.use();
-    for (unsigned int i = 0; i < amount; i++)
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-        shaderBlur.setInt("horizontal", horizontal);
-        glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
-        renderQuad();
-        horizontal = !horizontal;
-        if (first_iteration)
-            first_iteration = false;
+    auto const changes = BloomConfig::takeChanges();
+    auto const& settings = BloomConfig::current();
+    if (changes & BloomConfig::BlurPasses) {
+        buildBloomGraph(bloomWidth, bloomHeight, settings.blurPasses);
+    }
+    if (changes & (BloomConfig::BlurPasses | BloomConfig::ChangeDetection)) {
+        configureChangeDetector(settings);
+        changeDetector.invalidate();
+    }
+    if (!bloomGraphBuilt) {
+        GLTrace::endFrame();
+        return;
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    // 3. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
-    // --------------------------------------------------------------------------------------------------------------------------
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    shaderBloomFinal.use();
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
-    shaderBloomFinal.setFloat("exposure", 1.0f);
-    renderQuad();
+    // 1. upload this frame's parameters, shared by every pass
+    // --------------------------------------------------
+    BloomFrame frame{
+        .weight = {{0.227027f}, {0.1945946f}, {0.1216216f}, {0.054054f}, {0.016216f}},
+        .texelSize = {1.0f / static_cast<float>(bloomWidth), 1.0f / static_cast<float>(bloomHeight)},
+        .exposure = settings.exposure,
+    };
+    bloomUniforms.update(0, frame);
+    bloomUniforms.bindRange(BloomFrame::binding, 0, sizeof(BloomFrame));
+
+    // 2. check whether the scene changed since the blur was last computed
+    // --------------------------------------------------
+    changeDetector.update(colorBuffers[0], gameViewport);
+
+    // 3. blur and composite, the blur passes only run when the last result can't be reused
+    // --------------------------------------------------
+    recomputeBlur = !changeDetector.canReuse();
+    bloomGraph.execute(gameViewport);
+    if (recomputeBlur) {
+        changeDetector.markRecomputed();
+    }
+
+    GLTrace::endFrame();
 }
 
 using GLIssuePluginEvent = function_ptr_t<void, void*, int>;
@@ -303,7 +473,7 @@ extern "C" void setup(ModInfo& info) {
     info.version = VERSION;
     modInfo = info;
 	
-    getConfig().Load(); // Load the config file
+    BloomConfig::load(); // Load the config file
     getLogger().info("Completed setup!");
 }
 
@@ -323,6 +493,30 @@ MAKE_HOOK_MATCH(
 }
 
 
+// Effect assets are loaded for the whole session, so they're only searched for once.
+// SafePtrUnity keeps the managed object alive and tells whether Unity destroyed it since
+static SafePtrUnity<GlobalNamespace::BloomPrePassBloomTextureEffectSO> cachedBloomPrePassEffect;
+
+static GlobalNamespace::BloomPrePassBloomTextureEffectSO* findBloomPrePassEffect() {
+    using namespace GlobalNamespace;
+    using namespace UnityEngine;
+
+    if (cachedBloomPrePassEffect) {
+        return cachedBloomPrePassEffect.ptr();
+    }
+
+    auto bloomPrePassEffects = Resources::FindObjectsOfTypeAll<BloomPrePassBloomTextureEffectSO*>();
+    for (int i = 0; i < bloomPrePassEffects.Length(); i++) {
+        if (bloomPrePassEffects[i]->get_name() == "BloomPrePassLDBloomTextureEffect") {
+            cachedBloomPrePassEffect = bloomPrePassEffects[i];
+            return cachedBloomPrePassEffect.ptr();
+        }
+    }
+
+    PLogger.fmtLog<Paper::LogLevel::WRN>("Unable to find BloomPrePassLDBloomTextureEffect");
+    return nullptr;
+}
+
 MAKE_HOOK_MATCH(
         MainSystemInit_Init,
         &GlobalNamespace::MainSystemInit::Init,
@@ -335,26 +529,48 @@ MAKE_HOOK_MATCH(
     MainSystemInit_Init(self);
 
 
-    auto bloomPrePassEffects = Resources::FindObjectsOfTypeAll<BloomPrePassBloomTextureEffectSO*>();
-    for (int i = 0; i < bloomPrePassEffects.Length(); i++) {
-        BloomPrePassBloomTextureEffectSO* bloomPrePassEffect = bloomPrePassEffects[i];
-        if (bloomPrePassEffect->get_name() == "BloomPrePassLDBloomTextureEffect") {
-            self->dyn__bloomPrePassEffectContainer()->Init(bloomPrePassEffect);
-        }
+    auto* bloomPrePassEffect = findBloomPrePassEffect();
+    if (bloomPrePassEffect != nullptr) {
+        self->dyn__bloomPrePassEffectContainer()->Init(bloomPrePassEffect);
     }
-
 }
 
+// set by scene loads, both it and the coroutine only run on the main thread
+static bool rebindRequested = false;
+
 custom_types::Helpers::Coroutine renderCoroutine() {
     auto eventId = makeRequest_mainThread();
     GetGLIssuePluginEvent()(reinterpret_cast<void*>(bloomshader_Initialize), eventId);
 
     while (true) {
+        if (rebindRequested) {
+            rebindRequested = false;
+            GetGLIssuePluginEvent()(reinterpret_cast<void*>(bloomshader_Rebind), makeRequest_mainThread());
+        }
+
         GetGLIssuePluginEvent()(reinterpret_cast<void*>(bloomshader_Apply), -1);
         co_yield nullptr;
     }
 }
 
+// The one object driving the render coroutine, kept across scenes.
+// Held through SafePtrUnity so checking it after Unity destroyed it is safe
+static SafePtrUnity<BloomShaderGLSL::BloomShaderCoro> bloomController;
+
+static void ensureBloomController() {
+    using namespace UnityEngine;
+
+    if (bloomController) {
+        rebindRequested = true;
+        return;
+    }
+
+    auto go = GameObject::New_ctor("BloomShaderGLSL");
+    Object::DontDestroyOnLoad(go);
+    bloomController = go->AddComponent<BloomShaderGLSL::BloomShaderCoro*>();
+    bloomController->StartCoroutine(custom_types::Helpers::CoroutineHelper::New(renderCoroutine()));
+}
+
 DEFINE_TYPE(BloomShaderGLSL, BloomShaderCoro);
 
 // Called later on in the game loading - a good time to install function hooks
@@ -379,11 +595,11 @@ extern "C" void load() {
     std::function<void(UnityEngine::SceneManagement::Scene, ::UnityEngine::SceneManagement::LoadSceneMode)> onSceneChanged = [](UnityEngine::SceneManagement::Scene scene, ::UnityEngine::SceneManagement::LoadSceneMode) {
         if (!scene.IsValid()) return;
 
+        // pick up edits made to the config file while the game is running, off the main thread
+        BloomConfig::reload();
+
         PAPER_IL2CPP_CATCH_HANDLER(
-            auto go = UnityEngine::GameObject::New_ctor("BloomShaderGLSL");
-            UnityEngine::Object::DontDestroyOnLoad(go);
-            go->AddComponent<BloomShaderGLSL::BloomShaderCoro*>()->StartCoroutine(
-                    custom_types::Helpers::CoroutineHelper::New(renderCoroutine()));
+            ensureBloomController();
         )
     };
 
@@ -0,0 +1,116 @@
+#include "opengl/ChangeDetector.hpp"
+
+#include <algorithm>
+
+namespace {
+    constexpr GLsizeiptr SignatureBytes = ChangeDetector::SignatureSize * ChangeDetector::SignatureSize * 4;
+}
+
+void ChangeDetector::initialize() {
+    shader = Shaders::signature();
+    glGenVertexArrays(1, &emptyVAO);
+
+    glGenTextures(3, signatures);
+    glGenFramebuffers(3, signatureFBOs);
+    for (int i = 0; i < 3; i++) {
+        glBindTexture(GL_TEXTURE_2D, signatures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SignatureSize, SignatureSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, signatureFBOs[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, signatures[i], 0);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    for (auto& readback : readbacks) {
+        glGenBuffers(1, &readback.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, SignatureBytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void ChangeDetector::collectReadbacks() {
+    for (int i = 0; i < ReadbackSlots; i++) {
+        // the slot after the newest one is the oldest
+        auto& readback = readbacks[(nextReadback + i) % ReadbackSlots];
+        if (readback.fence == nullptr) continue;
+
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        auto const* pixels = static_cast<const uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, SignatureBytes, GL_MAP_READ_BIT));
+        if (pixels == nullptr) continue;
+
+        uint8_t previousDelta = 0, referenceDelta = 0;
+        for (GLsizeiptr cell = 0; cell < SignatureBytes; cell += 4) {
+            previousDelta = std::max(previousDelta, pixels[cell + 1]);
+            referenceDelta = std::max(referenceDelta, pixels[cell + 2]);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+        staticFrames = previousDelta <= Threshold ? staticFrames + 1 : 0;
+        // the reference check catches slow fades that never differ much from one frame to the next
+        reuse = hasReference && staticFrames >= StaticFramesBeforeReuse && referenceDelta <= Threshold;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void ChangeDetector::update(GLuint sceneTexture, GLint const (&viewport)[4]) {
+    collectReadbacks();
+
+    int const previousSignature = currentSignature;
+    currentSignature = 1 - currentSignature;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, signatureFBOs[currentSignature]);
+    glViewport(0, 0, SignatureSize, SignatureSize);
+    shader.use();
+    shader.scene.bind(sceneTexture);
+    shader.previous.bind(signatures[previousSignature]);
+    shader.reference.bind(signatures[ReferenceSignature]);
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+
+    // if every slot is still in flight, skip this frame's readback rather than wait
+    auto& readback = readbacks[nextReadback];
+    if (readback.fence == nullptr) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        glReadPixels(0, 0, SignatureSize, SignatureSize, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        nextReadback = (nextReadback + 1) % ReadbackSlots;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+bool ChangeDetector::canReuse() const {
+    return reuse;
+}
+
+void ChangeDetector::markRecomputed() {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, signatureFBOs[currentSignature]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, signatureFBOs[ReferenceSignature]);
+    glBlitFramebuffer(0, 0, SignatureSize, SignatureSize, 0, 0, SignatureSize, SignatureSize, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    hasReference = true;
+}
+
+void ChangeDetector::invalidate() {
+    // readbacks issued before this were compared against the old reference, they must not count towards reuse
+    for (auto& readback : readbacks) {
+        if (readback.fence == nullptr) continue;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+    }
+
+    hasReference = false;
+    staticFrames = 0;
+    reuse = false;
+}
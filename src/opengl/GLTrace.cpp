@@ -0,0 +1,289 @@
+#ifdef BLOOM_GL_TRACE
+
+#include "opengl/GLTrace.hpp"
+#include "main.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GLTrace {
+    namespace {
+        // Buffers are handed to the writer at the latest after this many frames, so a crash loses at most that much
+        constexpr uint32_t FramesPerFlush = 90;
+        constexpr size_t BufferWords = (1 << 20) / sizeof(uint32_t);
+        constexpr size_t BufferCount = 4;
+        constexpr size_t FrameHeaderWords = sizeof(FrameHeader) / sizeof(uint32_t);
+
+        struct Buffer {
+            std::unique_ptr<uint32_t[]> words;
+            size_t used = 0;
+        };
+
+        // Shared with the writer thread. Never destroyed, the writer thread is still waiting on it when the process exits
+        struct Writer {
+            std::vector<Buffer> buffers;
+            std::vector<Buffer*> freeBuffers;
+            std::deque<Buffer*> pendingBuffers;
+            std::mutex mutex;
+            std::condition_variable changed;
+        };
+        Writer* writer = nullptr;
+        FILE* file = nullptr;
+        uint32_t frameLimit = 0;
+
+        // Only touched by the render thread
+        Buffer* current = nullptr;
+        size_t frameStart = 0;
+        uint32_t frameIndex = 0;
+        uint32_t frameCalls = 0;
+        uint32_t frameDroppedCalls = 0;
+        uint32_t framesInBuffer = 0;
+
+        void writerLoop() {
+            while (true) {
+                std::unique_lock lock(writer->mutex);
+                writer->changed.wait(lock, [] { return !writer->pendingBuffers.empty(); });
+                Buffer* buffer = writer->pendingBuffers.front();
+                writer->pendingBuffers.pop_front();
+                lock.unlock();
+
+                fwrite(buffer->words.get(), sizeof(uint32_t), buffer->used, file);
+                fflush(file);
+                buffer->used = 0;
+
+                lock.lock();
+                writer->freeBuffers.push_back(buffer);
+                lock.unlock();
+                writer->changed.notify_all();
+            }
+        }
+
+        // Takes a free buffer and opens a frame in it. Without a free buffer, the frame is dropped entirely.
+        void beginFrame() {
+            {
+                std::lock_guard lock(writer->mutex);
+                if (!writer->freeBuffers.empty()) {
+                    current = writer->freeBuffers.back();
+                    writer->freeBuffers.pop_back();
+                }
+            }
+            if (current == nullptr) return;
+
+            frameStart = current->used;
+            current->used += FrameHeaderWords;
+        }
+
+        void submitCurrent() {
+            {
+                std::lock_guard lock(writer->mutex);
+                writer->pendingBuffers.push_back(current);
+            }
+            writer->changed.notify_all();
+            current = nullptr;
+            framesInBuffer = 0;
+        }
+    }
+
+    void start(const char *path, uint32_t limit) {
+        if (writer != nullptr) return;
+
+        file = fopen(path, "wb");
+        if (file == nullptr) {
+            PLogger.fmtLog<Paper::LogLevel::ERR>("Unable to open GL trace file {}", path);
+            return;
+        }
+
+        frameLimit = limit;
+        FileHeader header{FileMagic, FormatVersion};
+        fwrite(&header, sizeof(header), 1, file);
+
+        writer = new Writer();
+        writer->buffers.resize(BufferCount);
+        for (auto& buffer : writer->buffers) {
+            buffer.words = std::make_unique<uint32_t[]>(BufferWords);
+            writer->freeBuffers.push_back(&buffer);
+        }
+
+        std::thread(writerLoop).detach();
+
+        PLogger.fmtLog<Paper::LogLevel::INF>("Recording GL trace to {}", path);
+        // hooked calls made before recording started were counted as dropped, they don't belong to frame 0
+        frameCalls = 0;
+        frameDroppedCalls = 0;
+        beginFrame();
+    }
+
+    void endFrame() {
+        if (file == nullptr) return;
+
+        if (current != nullptr) {
+            FrameHeader header{
+                FrameMagic,
+                frameIndex,
+                static_cast<uint32_t>(current->used - frameStart - FrameHeaderWords),
+                frameCalls,
+                frameDroppedCalls
+            };
+            memcpy(current->words.get() + frameStart, &header, sizeof(header));
+            framesInBuffer++;
+
+            // hand the buffer off once it's half full, frames are rarely bigger than that
+            if (current->used > BufferWords / 2 || framesInBuffer >= FramesPerFlush) {
+                submitCurrent();
+            }
+        } else if (frameCalls + frameDroppedCalls > 0) {
+            PLogger.fmtLog<Paper::LogLevel::WRN>("GL trace writer fell behind, dropped frame {}", frameIndex);
+        }
+
+        frameIndex++;
+        frameCalls = 0;
+        frameDroppedCalls = 0;
+
+        if (current == nullptr) {
+            beginFrame();
+        } else {
+            frameStart = current->used;
+            current->used += FrameHeaderWords;
+        }
+
+        if (frameIndex >= frameLimit) {
+            PLogger.fmtLog<Paper::LogLevel::INF>("GL trace reached its limit of {} frames", frameLimit);
+            stop();
+        }
+    }
+
+    void stop() {
+        if (file == nullptr) return;
+
+        if (current != nullptr) {
+            // drop the frame that is still open, it is incomplete
+            current->used = frameStart;
+            if (current->used > 0) {
+                submitCurrent();
+            } else {
+                std::lock_guard lock(writer->mutex);
+                writer->freeBuffers.push_back(current);
+                current = nullptr;
+            }
+        }
+
+        // every buffer is back in the free list once the writer is done with them
+        {
+            std::unique_lock lock(writer->mutex);
+            writer->changed.wait(lock, [] { return writer->freeBuffers.size() == BufferCount; });
+        }
+
+        fclose(file);
+        file = nullptr;
+        PLogger.fmtLog<Paper::LogLevel::INF>("Stopped GL trace after {} frames", frameIndex);
+    }
+
+    Call::Call(Op op) : recording(current != nullptr) {
+        if (!recording) {
+            frameDroppedCalls++;
+            return;
+        }
+
+        start = current->used;
+        *this << uint32_t(0);
+        if (recording) {
+            CallHeader header{static_cast<uint16_t>(op), 0};
+            memcpy(current->words.get() + start, &header, sizeof(header));
+        }
+    }
+
+    Call::~Call() {
+        if (!recording) return;
+
+        size_t words = current->used - start - 1;
+        if (words > UINT16_MAX) {
+            // too big to describe in a CallHeader
+            current->used = start;
+            frameDroppedCalls++;
+            return;
+        }
+
+        auto* header = reinterpret_cast<CallHeader*>(current->words.get() + start);
+        header->words = static_cast<uint16_t>(words);
+        frameCalls++;
+    }
+
+    Call& Call::operator<<(uint32_t value) {
+        if (!recording) return *this;
+
+        if (current->used >= BufferWords) {
+            // out of space, roll back the partially written call
+            current->used = start;
+            recording = false;
+            frameDroppedCalls++;
+            return *this;
+        }
+        current->words[current->used++] = value;
+        return *this;
+    }
+
+    Call& Call::operator<<(int32_t value) {
+        return *this << static_cast<uint32_t>(value);
+    }
+
+    Call& Call::operator<<(float value) {
+        uint32_t word;
+        memcpy(&word, &value, sizeof(word));
+        return *this << word;
+    }
+
+    Call& Call::operator<<(uint64_t value) {
+        return *this << static_cast<uint32_t>(value) << static_cast<uint32_t>(value >> 32);
+    }
+
+    Call& Call::operator<<(int64_t value) {
+        return *this << static_cast<uint64_t>(value);
+    }
+
+    Call& Call::beginBlob(size_t size) {
+        *this << static_cast<uint32_t>(size);
+        blobStart = recording ? current->used : 0;
+        blobBytes = 0;
+        return *this;
+    }
+
+    Call& Call::append(const void *data, size_t size) {
+        if (!recording) return *this;
+
+        // words that aren't already partially filled by the previous append()
+        size_t const newWords = (blobBytes + size + 3) / 4 - (blobBytes + 3) / 4;
+        if (current->used + newWords > BufferWords) {
+            current->used = start;
+            recording = false;
+            frameDroppedCalls++;
+            return *this;
+        }
+
+        // zero first so the padding of the last word is deterministic
+        std::fill_n(current->words.get() + current->used, newWords, 0u);
+        memcpy(reinterpret_cast<uint8_t*>(current->words.get() + blobStart) + blobBytes, data, size);
+        current->used += newWords;
+        blobBytes += size;
+        return *this;
+    }
+
+    Call& Call::endBlob() {
+        blobBytes = 0;
+        return *this;
+    }
+
+    Call& Call::names(GLsizei n, const GLuint *names) {
+        *this << static_cast<int32_t>(n);
+        for (GLsizei i = 0; i < n; i++) *this << names[i];
+        return *this;
+    }
+}
+
+#endif
@@ -0,0 +1,274 @@
+#include "opengl/RenderGraph.hpp"
+#include "main.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    // lifetime end of retained resources, past every pass
+    constexpr size_t EndOfFrame = std::numeric_limits<size_t>::max();
+}
+
+void RenderGraph::PassBuilder::read(Resource resource) {
+    graph.passes[pass].reads.push_back(resource);
+}
+
+void RenderGraph::PassBuilder::write(Resource resource) {
+    graph.passes[pass].writes.push_back(resource);
+}
+
+void RenderGraph::PassBuilder::runIf(bool const* condition) {
+    graph.passes[pass].condition = condition;
+}
+
+GLuint RenderGraph::Context::texture(Resource resource) const {
+    auto const& node = graph.resources.at(resource);
+    switch (node.kind) {
+        case ResourceKind::Transient:
+            return graph.physicalTextures.at(node.physical).texture;
+        case ResourceKind::ImportedTexture:
+            return node.texture;
+        default:
+            throw std::runtime_error("Render graph resource " + node.name + " can't be read as a texture");
+    }
+}
+
+void RenderGraph::Context::use(Shader& shader) const {
+    if (shader.Shader_ID == boundProgram) return;
+    shader.use();
+    boundProgram = shader.Shader_ID;
+}
+
+void RenderGraph::Context::bindRange(UniformBuffer const& buffer, GLuint binding, GLintptr offset, GLsizeiptr size) const {
+    UniformRange const range{buffer.Buffer_ID, offset, size};
+    if (binding >= boundRanges.size()) boundRanges.resize(binding + 1);
+    if (boundRanges[binding] == range) return;
+    buffer.bindRange(binding, offset, size);
+    boundRanges[binding] = range;
+}
+
+RenderGraph::Resource RenderGraph::createTexture(std::string name, TextureDesc desc) {
+    resources.push_back({.name = std::move(name), .kind = ResourceKind::Transient, .desc = desc});
+    return resources.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::importTexture(std::string name, GLuint texture) {
+    resources.push_back({.name = std::move(name), .kind = ResourceKind::ImportedTexture, .texture = texture});
+    return resources.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::importFramebuffer(std::string name, GLuint framebuffer) {
+    resources.push_back({.name = std::move(name), .kind = ResourceKind::ImportedFramebuffer, .framebuffer = framebuffer});
+    return resources.size() - 1;
+}
+
+void RenderGraph::markOutput(Resource resource) {
+    resources.at(resource).output = true;
+}
+
+void RenderGraph::retain(Resource resource) {
+    resources.at(resource).retained = true;
+}
+
+void RenderGraph::addPass(std::string name, Setup const& setup, Execute execute) {
+    passes.push_back({.name = std::move(name), .execute = std::move(execute)});
+    PassBuilder builder(*this, passes.size() - 1);
+    setup(builder);
+}
+
+void RenderGraph::cullPasses() {
+    std::vector<bool> needed(resources.size());
+    for (size_t i = 0; i < resources.size(); i++) needed[i] = resources[i].output;
+
+    // walk backwards, a pass is needed when it writes something a later needed pass (or an output) uses
+    for (size_t i = passes.size(); i-- > 0;) {
+        auto& pass = passes[i];
+        pass.culled = std::none_of(pass.writes.begin(), pass.writes.end(), [&](Resource r) { return needed[r]; });
+        if (pass.culled) continue;
+
+        for (Resource r : pass.reads) needed[r] = true;
+    }
+
+    schedule.clear();
+    for (size_t i = 0; i < passes.size(); i++) {
+        if (!passes[i].culled) schedule.push_back(i);
+    }
+}
+
+void RenderGraph::computeLifetimes() {
+    std::vector<bool> used(resources.size());
+    std::vector<bool> written(resources.size());
+
+    for (size_t step = 0; step < schedule.size(); step++) {
+        auto const& pass = passes[schedule[step]];
+
+        for (Resource r : pass.reads) {
+            auto& node = resources[r];
+            if (node.kind == ResourceKind::ImportedFramebuffer) {
+                throw std::runtime_error("Pass " + pass.name + " reads framebuffer " + node.name);
+            }
+            if (node.kind == ResourceKind::Transient && !written[r]) {
+                throw std::runtime_error("Pass " + pass.name + " reads " + node.name + " before it is written");
+            }
+            node.lastUse = step;
+        }
+
+        for (Resource r : pass.writes) {
+            auto& node = resources[r];
+            if (node.kind == ResourceKind::ImportedTexture) {
+                throw std::runtime_error("Pass " + pass.name + " writes imported texture " + node.name);
+            }
+            if (!used[r]) {
+                node.firstUse = step;
+                node.writeCondition = pass.condition;
+            }
+            used[r] = true;
+            written[r] = true;
+            node.lastUse = std::max(node.lastUse, step);
+        }
+    }
+
+    for (auto& node : resources) {
+        if (node.retained) node.lastUse = EndOfFrame;
+    }
+}
+
+bool RenderGraph::canShare(PhysicalTexture const& physical, ResourceNode const& resource) const {
+    if (!(physical.desc == resource.desc)) return false;
+
+    return std::all_of(physical.resources.begin(), physical.resources.end(), [&](Resource r) {
+        auto const& other = resources[r];
+        bool const disjoint = other.lastUse < resource.firstUse || resource.lastUse < other.firstUse;
+        if (!disjoint) return false;
+
+        // a retained resource survives into the next frame. Anything sharing its memory must only run when its
+        // producer runs, or it would overwrite the retained contents in a frame where they aren't recomputed
+        if (other.retained || resource.retained) return other.writeCondition == resource.writeCondition;
+        return true;
+    });
+}
+
+void RenderGraph::allocate() {
+    std::vector<Resource> transients;
+    for (Resource r = 0; r < resources.size(); r++) {
+        auto const& node = resources[r];
+        bool const scheduled = std::any_of(schedule.begin(), schedule.end(), [&](size_t p) {
+            auto const& writes = passes[p].writes;
+            return std::find(writes.begin(), writes.end(), r) != writes.end();
+        });
+        if (node.kind == ResourceKind::Transient && scheduled) transients.push_back(r);
+    }
+
+    // greedy interval allocation, in order of first use
+    std::stable_sort(transients.begin(), transients.end(), [&](Resource a, Resource b) {
+        return resources[a].firstUse < resources[b].firstUse;
+    });
+
+    physicalTextures.clear();
+    for (Resource r : transients) {
+        auto& node = resources[r];
+        auto it = std::find_if(physicalTextures.begin(), physicalTextures.end(), [&](PhysicalTexture const& physical) {
+            return canShare(physical, node);
+        });
+        if (it == physicalTextures.end()) {
+            physicalTextures.push_back({.desc = node.desc});
+            it = physicalTextures.end() - 1;
+        }
+        it->resources.push_back(r);
+        node.physical = static_cast<int>(it - physicalTextures.begin());
+    }
+
+    for (auto& physical : physicalTextures) {
+        glGenTextures(1, &physical.texture);
+        glBindTexture(GL_TEXTURE_2D, physical.texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, physical.desc.internalFormat, physical.desc.width, physical.desc.height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glGenFramebuffers(1, &physical.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, physical.framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, physical.texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            PLogger.fmtLog<Paper::LogLevel::INF>("Framebuffer not complete!");
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderGraph::compile() {
+    release();
+
+    for (auto const& pass : passes) {
+        if (pass.writes.size() != 1) {
+            throw std::runtime_error("Pass " + pass.name + " must write exactly one target");
+        }
+    }
+    for (auto const& node : resources) {
+        if (node.kind == ResourceKind::Transient && (node.desc.width <= 0 || node.desc.height <= 0)) {
+            throw std::runtime_error("Render graph texture " + node.name + " has no size");
+        }
+    }
+
+    cullPasses();
+    computeLifetimes();
+    allocate();
+
+    auto const transientCount = std::count_if(resources.begin(), resources.end(), [](ResourceNode const& node) {
+        return node.kind == ResourceKind::Transient && node.physical >= 0;
+    });
+    PLogger.fmtLog<Paper::LogLevel::INF>("Render graph compiled: {} of {} passes, {} transient textures in {} allocations",
+                                         schedule.size(), passes.size(), transientCount, physicalTextures.size());
+}
+
+void RenderGraph::execute(GLint const (&viewport)[4]) {
+    Context const context(*this);
+
+    std::array<GLint, 4> const callerViewport = {viewport[0], viewport[1], viewport[2], viewport[3]};
+    std::array<GLint, 4> boundViewport = callerViewport;
+    auto setViewport = [&](std::array<GLint, 4> const& value) {
+        if (value == boundViewport) return;
+        glViewport(value[0], value[1], value[2], value[3]);
+        boundViewport = value;
+    };
+
+    bool first = true;
+    GLuint boundFramebuffer = 0;
+
+    for (size_t p : schedule) {
+        auto const& pass = passes[p];
+        if (pass.condition != nullptr && !*pass.condition) continue;
+
+        auto const& target = resources[pass.writes.front()];
+        bool const transient = target.kind == ResourceKind::Transient;
+        GLuint const framebuffer = transient ? physicalTextures[target.physical].framebuffer : target.framebuffer;
+
+        // the framebuffer bound before the first pass is unknown, after that only bind what changed
+        if (first || framebuffer != boundFramebuffer) {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            boundFramebuffer = framebuffer;
+        }
+        first = false;
+
+        // imported framebuffers are drawn with the caller's viewport
+        setViewport(transient ? std::array<GLint, 4>{0, 0, target.desc.width, target.desc.height} : callerViewport);
+
+        pass.execute(context);
+    }
+
+    setViewport(callerViewport);
+    if (!first && boundFramebuffer != 0) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
+
+void RenderGraph::release() {
+    for (auto& physical : physicalTextures) {
+        glDeleteFramebuffers(1, &physical.framebuffer);
+        glDeleteTextures(1, &physical.texture);
+    }
+    physicalTextures.clear();
+    for (auto& node : resources) node.physical = -1;
+}
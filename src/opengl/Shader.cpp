@@ -2,6 +2,8 @@
 #include "main.hpp"
 
 #include <string_view>
+#include <algorithm>
+#include <vector>
 
 Shader Shader::fromFile(const char * vertexPath, const char *fragmentPath) {
     // 1. retrieve the vertex/fragment source code from filePath
@@ -79,20 +81,57 @@ Shader::Shader(const char *vShaderCode, const char *fShaderCode) {
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    cacheUniformLocations();
+}
+
+void Shader::cacheUniformLocations() {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(Shader_ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(Shader_ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<GLchar> nameBuffer(std::max(maxLength, 1));
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(Shader_ID, i, maxLength, &length, &size, &type, nameBuffer.data());
+
+        std::string name(nameBuffer.data(), length);
+        GLint location = glGetUniformLocation(Shader_ID, name.c_str());
+        // uniform block members have no location
+        if (location == -1) continue;
+
+        uniformLocations[name] = location;
+        // arrays are reported as "name[0]", also allow looking them up by "name"
+        if (name.ends_with("[0]")) {
+            uniformLocations[name.substr(0, name.size() - 3)] = location;
+        }
+    }
 }
 
 void Shader::use() {
     glUseProgram(Shader_ID);
 }
 
-void Shader::setBool(const std::string &name, bool value) const {
-    glUniform1i(glGetUniformLocation(Shader_ID, name.c_str()), (int)value);
+void Shader::set(Uniform<bool> uniform, bool value) const {
+    glUniform1i(uniform.location, (int)value);
 }
 
-void Shader::setInt(const std::string &name, int value) const {
-    glUniform1i(glGetUniformLocation(Shader_ID, name.c_str()), value);
+void Shader::set(Uniform<int> uniform, int value) const {
+    glUniform1i(uniform.location, value);
 }
 
-void Shader::setFloat(const std::string &name, float value) const {
-    glUniform1f(glGetUniformLocation(Shader_ID, name.c_str()), value);
+void Shader::set(Uniform<float> uniform, float value) const {
+    glUniform1f(uniform.location, value);
+}
+
+GLint Shader::location(const std::string &name) const {
+    auto it = uniformLocations.find(name);
+    if (it == uniformLocations.end()) {
+        // Not necessarily an error, the driver strips uniforms that the shader doesn't use
+        PLogger.fmtLog<Paper::LogLevel::WRN>("Uniform {} is not active in program {}", name, Shader_ID);
+        return -1;
+    }
+    return it->second;
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "opengl/UniformBuffer.hpp"
+
+UniformBuffer::UniformBuffer(GLsizeiptr size) : Size(size) {
+    glGenBuffers(1, &Buffer_ID);
+    glBindBuffer(GL_UNIFORM_BUFFER, Buffer_ID);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::update(GLintptr offset, GLsizeiptr size, const void *data) const {
+    glBindBuffer(GL_UNIFORM_BUFFER, Buffer_ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::bindRange(GLuint binding, GLintptr offset, GLsizeiptr size) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, Buffer_ID, offset, size);
+}
+
+GLint UniformBuffer::offsetAlignment() {
+    static GLint alignment = []() {
+        GLint value = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+        return value > 0 ? value : 256;
+    }();
+    return alignment;
+}
@@ -0,0 +1,629 @@
+// Replays a GL trace recorded with BLOOM_GL_TRACE (see include/opengl/GLTrace.hpp) on a headless EGL context
+// and reports how long every call and every frame took.
+//
+// Objects are recreated under new names, textures and framebuffers that were created by the game rather than the mod
+// are replaced by a placeholder texture and an offscreen framebuffer of --width x --height.
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl32.h>
+
+#include "opengl/GLTraceFormat.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace GLTrace;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    struct Options {
+        const char* tracePath = nullptr;
+        int width = 1920;
+        int height = 1080;
+        // glFinish after every call, so per-call times include the GPU work
+        bool syncCalls = false;
+        bool perFrame = false;
+    };
+
+    struct CallStats {
+        uint64_t count = 0;
+        double totalMs = 0;
+        double maxMs = 0;
+    };
+
+    struct FrameStats {
+        uint32_t index;
+        uint32_t calls;
+        uint32_t droppedCalls;
+        double submitMs;
+        double finishMs;
+    };
+
+    // Reads the words of a single call
+    class Reader {
+    public:
+        Reader(const uint32_t* words, size_t count) : words(words), count(count) {}
+
+        uint32_t u32() {
+            if (position >= count) throw std::runtime_error("Call is shorter than its arguments");
+            return words[position++];
+        }
+
+        int32_t i32() { return static_cast<int32_t>(u32()); }
+
+        float f32() {
+            uint32_t word = u32();
+            float value;
+            memcpy(&value, &word, sizeof(value));
+            return value;
+        }
+
+        uint64_t u64() {
+            uint64_t low = u32();
+            return low | (static_cast<uint64_t>(u32()) << 32);
+        }
+
+        int64_t i64() { return static_cast<int64_t>(u64()); }
+
+        std::string_view blob() {
+            uint32_t size = u32();
+            size_t blobWords = (size + 3) / 4;
+            if (position + blobWords > count) throw std::runtime_error("Blob is longer than its call");
+            std::string_view data(reinterpret_cast<const char*>(words + position), size);
+            position += blobWords;
+            return data;
+        }
+
+        std::vector<GLuint> names() {
+            std::vector<GLuint> result(i32());
+            for (auto& name : result) name = u32();
+            return result;
+        }
+
+    private:
+        const uint32_t* words;
+        size_t count;
+        size_t position = 0;
+    };
+
+    class Replayer {
+    public:
+        explicit Replayer(Options const& options) : options(options) {
+            // stands in for the game's framebuffers, including the default one
+            glGenTextures(1, &backbufferTexture);
+            glBindTexture(GL_TEXTURE_2D, backbufferTexture);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, options.width, options.height);
+            glGenFramebuffers(1, &backbuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, backbuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, backbufferTexture, 0);
+            glViewport(0, 0, options.width, options.height);
+
+            // stands in for the game's textures, e.g. the camera texture
+            glGenTextures(1, &placeholderTexture);
+            glBindTexture(GL_TEXTURE_2D, placeholderTexture);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, options.width, options.height);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        void call(Op op, Reader& r) {
+            switch (op) {
+                case Op::ActiveTexture: glActiveTexture(r.u32()); break;
+                case Op::AttachShader: {
+                    GLuint program, shader;
+                    if (!resolve(programs, r.u32(), "glAttachShader", program)) break;
+                    if (!resolve(shaders, r.u32(), "glAttachShader", shader)) break;
+                    glAttachShader(program, shader);
+                    break;
+                }
+                case Op::BindBuffer: {
+                    GLenum target = r.u32();
+                    GLuint buffer = lookup(buffers, r.u32());
+                    if (target == GL_PIXEL_PACK_BUFFER) packBufferBound = buffer != 0;
+                    glBindBuffer(target, buffer);
+                    break;
+                }
+                case Op::BindBufferRange: {
+                    GLenum target = r.u32();
+                    GLuint index = r.u32();
+                    GLuint buffer = lookup(buffers, r.u32());
+                    GLintptr offset = r.i64();
+                    glBindBufferRange(target, index, buffer, offset, r.i64());
+                    break;
+                }
+                case Op::BindFramebuffer: {
+                    GLenum target = r.u32();
+                    glBindFramebuffer(target, framebuffer(r.u32()));
+                    break;
+                }
+                case Op::BindTexture: {
+                    GLenum target = r.u32();
+                    glBindTexture(target, texture(r.u32()));
+                    break;
+                }
+                case Op::BindVertexArray: glBindVertexArray(lookup(vertexArrays, r.u32())); break;
+                case Op::BlitFramebuffer: {
+                    GLint srcX0 = r.i32(), srcY0 = r.i32(), srcX1 = r.i32(), srcY1 = r.i32();
+                    GLint dstX0 = r.i32(), dstY0 = r.i32(), dstX1 = r.i32(), dstY1 = r.i32();
+                    GLbitfield mask = r.u32();
+                    glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, r.u32());
+                    break;
+                }
+                case Op::BufferData: {
+                    GLenum target = r.u32();
+                    GLsizeiptr size = r.i64();
+                    GLenum usage = r.u32();
+                    auto data = r.blob();
+                    glBufferData(target, size, data.empty() ? nullptr : data.data(), usage);
+                    break;
+                }
+                case Op::BufferSubData: {
+                    GLenum target = r.u32();
+                    GLintptr offset = r.i64();
+                    auto data = r.blob();
+                    glBufferSubData(target, offset, data.size(), data.data());
+                    break;
+                }
+                case Op::Clear: glClear(r.u32()); break;
+                case Op::ClientWaitSync: {
+                    GLsync sync;
+                    if (!resolve(syncs, r.u64(), "glClientWaitSync", sync)) break;
+                    GLbitfield flags = r.u32();
+                    glClientWaitSync(sync, flags, r.u64());
+                    break;
+                }
+                case Op::CompileShader: {
+                    GLuint shader;
+                    if (resolve(shaders, r.u32(), "glCompileShader", shader)) glCompileShader(shader);
+                    break;
+                }
+                case Op::CreateProgram: programs[r.u32()] = glCreateProgram(); break;
+                case Op::CreateShader: {
+                    GLenum type = r.u32();
+                    shaders[r.u32()] = glCreateShader(type);
+                    break;
+                }
+                case Op::DeleteBuffers: remove(buffers, r.names(), glDeleteBuffers); break;
+                case Op::DeleteFramebuffers: remove(framebuffers, r.names(), glDeleteFramebuffers); break;
+                case Op::DeleteShader: {
+                    GLuint shader;
+                    if (resolve(shaders, r.u32(), "glDeleteShader", shader)) glDeleteShader(shader);
+                    break;
+                }
+                case Op::DeleteSync: {
+                    auto it = syncs.find(r.u64());
+                    if (it != syncs.end()) {
+                        glDeleteSync(it->second);
+                        syncs.erase(it);
+                    }
+                    break;
+                }
+                case Op::DeleteTextures: remove(textures, r.names(), glDeleteTextures); break;
+                case Op::DeleteVertexArrays: remove(vertexArrays, r.names(), glDeleteVertexArrays); break;
+                case Op::Disable: glDisable(r.u32()); break;
+                case Op::DrawArrays: {
+                    GLenum mode = r.u32();
+                    GLint first = r.i32();
+                    glDrawArrays(mode, first, r.i32());
+                    break;
+                }
+                case Op::EnableVertexAttribArray: glEnableVertexAttribArray(r.u32()); break;
+                case Op::FenceSync: {
+                    GLenum condition = r.u32();
+                    GLbitfield flags = r.u32();
+                    syncs[r.u64()] = glFenceSync(condition, flags);
+                    break;
+                }
+                case Op::FramebufferTexture2D: {
+                    GLenum target = r.u32();
+                    GLenum attachment = r.u32();
+                    GLenum textarget = r.u32();
+                    GLuint texture = lookup(textures, r.u32());
+                    glFramebufferTexture2D(target, attachment, textarget, texture, r.i32());
+                    break;
+                }
+                case Op::GenBuffers: generate(buffers, r.names(), glGenBuffers); break;
+                case Op::GenFramebuffers: generate(framebuffers, r.names(), glGenFramebuffers); break;
+                case Op::GenTextures: generate(textures, r.names(), glGenTextures); break;
+                case Op::GenVertexArrays: generate(vertexArrays, r.names(), glGenVertexArrays); break;
+                case Op::GetUniformLocation: {
+                    GLuint tracedProgram = r.u32();
+                    std::string name(r.blob());
+                    GLint tracedLocation = r.i32();
+                    GLuint program;
+                    if (!resolve(programs, tracedProgram, "glGetUniformLocation", program)) break;
+                    uniformLocations[{tracedProgram, tracedLocation}] = glGetUniformLocation(program, name.c_str());
+                    break;
+                }
+                case Op::LinkProgram: {
+                    GLuint program;
+                    if (!resolve(programs, r.u32(), "glLinkProgram", program)) break;
+                    glLinkProgram(program);
+                    GLint linked = GL_FALSE;
+                    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+                    if (!linked) fprintf(stderr, "warning: program %u failed to link\n", program);
+                    break;
+                }
+                case Op::MapBufferRange: {
+                    GLenum target = r.u32();
+                    GLintptr offset = r.i64();
+                    GLsizeiptr length = r.i64();
+                    glMapBufferRange(target, offset, length, r.u32());
+                    break;
+                }
+                case Op::ReadPixels: {
+                    GLint x = r.i32(), y = r.i32();
+                    GLsizei width = r.i32(), height = r.i32();
+                    GLenum format = r.u32();
+                    GLenum type = r.u32();
+                    uint64_t pixels = r.u64();
+                    if (packBufferBound) {
+                        glReadPixels(x, y, width, height, format, type, reinterpret_cast<void*>(pixels));
+                    } else {
+                        // client memory reads are synchronous, replay them into scratch memory
+                        readScratch.resize(static_cast<size_t>(width) * height * 16);
+                        glReadPixels(x, y, width, height, format, type, readScratch.data());
+                    }
+                    break;
+                }
+                case Op::ShaderSource: {
+                    GLuint shader;
+                    if (!resolve(shaders, r.u32(), "glShaderSource", shader)) break;
+                    auto source = r.blob();
+                    const GLchar* string = source.data();
+                    GLint length = static_cast<GLint>(source.size());
+                    glShaderSource(shader, 1, &string, &length);
+                    break;
+                }
+                case Op::TexImage2D: {
+                    GLenum target = r.u32();
+                    GLint level = r.i32();
+                    GLint internalformat = r.i32();
+                    GLsizei width = r.i32();
+                    GLsizei height = r.i32();
+                    GLint border = r.i32();
+                    GLenum format = r.u32();
+                    glTexImage2D(target, level, internalformat, width, height, border, format, r.u32(), nullptr);
+                    break;
+                }
+                case Op::TexParameteri: {
+                    GLenum target = r.u32();
+                    GLenum pname = r.u32();
+                    glTexParameteri(target, pname, r.i32());
+                    break;
+                }
+                case Op::TexStorage2D: {
+                    GLenum target = r.u32();
+                    GLsizei levels = r.i32();
+                    GLenum internalformat = r.u32();
+                    GLsizei width = r.i32();
+                    glTexStorage2D(target, levels, internalformat, width, r.i32());
+                    break;
+                }
+                case Op::Uniform1f: {
+                    GLint location = uniformLocation(r.i32());
+                    glUniform1f(location, r.f32());
+                    break;
+                }
+                case Op::Uniform1i: {
+                    GLint location = uniformLocation(r.i32());
+                    glUniform1i(location, r.i32());
+                    break;
+                }
+                case Op::UnmapBuffer: glUnmapBuffer(r.u32()); break;
+                case Op::UseProgram: {
+                    currentProgram = r.u32();
+                    GLuint program = 0;
+                    if (currentProgram != 0 && !resolve(programs, currentProgram, "glUseProgram", program)) break;
+                    glUseProgram(program);
+                    break;
+                }
+                case Op::VertexAttribPointer: {
+                    GLuint index = r.u32();
+                    GLint size = r.i32();
+                    GLenum type = r.u32();
+                    GLboolean normalized = r.u32();
+                    GLsizei stride = r.i32();
+                    glVertexAttribPointer(index, size, type, normalized, stride, reinterpret_cast<const void*>(r.u64()));
+                    break;
+                }
+                case Op::Viewport: {
+                    GLint x = r.i32(), y = r.i32();
+                    GLsizei width = r.i32();
+                    glViewport(x, y, width, r.i32());
+                    break;
+                }
+                default:
+                    throw std::runtime_error("Unknown op " + std::to_string(static_cast<int>(op)));
+            }
+        }
+
+    private:
+        using NameMap = std::unordered_map<GLuint, GLuint>;
+
+        Options const& options;
+        GLuint backbuffer = 0;
+        GLuint backbufferTexture = 0;
+        GLuint placeholderTexture = 0;
+
+        NameMap textures, framebuffers, buffers, vertexArrays, shaders, programs;
+        std::map<std::pair<GLuint, GLint>, GLint> uniformLocations;
+        std::unordered_map<uint64_t, GLsync> syncs;
+        GLuint currentProgram = 0;
+        bool packBufferBound = false;
+        std::vector<uint8_t> readScratch;
+
+        static GLuint lookup(NameMap const& names, GLuint traced) {
+            if (traced == 0) return 0;
+            auto it = names.find(traced);
+            return it != names.end() ? it->second : 0;
+        }
+
+        // objects whose create call was dropped while recording are unknown, the calls using them are skipped
+        template<typename Map>
+        static bool resolve(Map const& names, typename Map::key_type traced, const char* call, typename Map::mapped_type& name) {
+            auto it = names.find(traced);
+            if (it == names.end()) {
+                fprintf(stderr, "warning: skipping %s, object %llu was never created\n", call, static_cast<unsigned long long>(traced));
+                return false;
+            }
+            name = it->second;
+            return true;
+        }
+
+        GLuint texture(GLuint traced) const {
+            if (traced == 0) return 0;
+            auto it = textures.find(traced);
+            return it != textures.end() ? it->second : placeholderTexture;
+        }
+
+        GLuint framebuffer(GLuint traced) const {
+            auto it = framebuffers.find(traced);
+            return it != framebuffers.end() ? it->second : backbuffer;
+        }
+
+        GLint uniformLocation(GLint traced) const {
+            auto it = uniformLocations.find({currentProgram, traced});
+            return it != uniformLocations.end() ? it->second : -1;
+        }
+
+        static void generate(NameMap& names, std::vector<GLuint> const& traced, void (*gen)(GLsizei, GLuint*)) {
+            std::vector<GLuint> created(traced.size());
+            gen(static_cast<GLsizei>(created.size()), created.data());
+            for (size_t i = 0; i < traced.size(); i++) names[traced[i]] = created[i];
+        }
+
+        static void remove(NameMap& names, std::vector<GLuint> const& traced, void (*del)(GLsizei, const GLuint*)) {
+            std::vector<GLuint> existing;
+            for (GLuint name : traced) {
+                auto it = names.find(name);
+                if (it == names.end()) continue;
+                existing.push_back(it->second);
+                names.erase(it);
+            }
+            del(static_cast<GLsizei>(existing.size()), existing.data());
+        }
+    };
+
+    void createContext(Options const& options) {
+        EGLDisplay display = EGL_NO_DISPLAY;
+
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (display == EGL_NO_DISPLAY) {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+            throw std::runtime_error("Unable to initialize EGL");
+        }
+
+        const EGLint configAttributes[] = {
+                EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+                EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+                EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+            throw std::runtime_error("No EGL config for OpenGL ES 3");
+        }
+
+        eglBindAPI(EGL_OPENGL_ES_API);
+        const EGLint contextAttributes[] = {
+                EGL_CONTEXT_MAJOR_VERSION, 3,
+                EGL_CONTEXT_MINOR_VERSION, 2,
+                EGL_NONE
+        };
+        EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (context == EGL_NO_CONTEXT) {
+            throw std::runtime_error("Unable to create an OpenGL ES 3.2 context");
+        }
+
+        // everything is drawn into an offscreen framebuffer, the surface only exists for drivers without surfaceless contexts
+        const EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        if (!eglMakeCurrent(display, surface, surface, context)) {
+            throw std::runtime_error("Unable to make the EGL context current");
+        }
+
+        fprintf(stderr, "Replaying on %s (%s), %dx%d\n",
+                reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+                reinterpret_cast<const char*>(glGetString(GL_VERSION)),
+                options.width, options.height);
+    }
+
+    std::vector<uint32_t> readTrace(const char* path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) throw std::runtime_error(std::string("Unable to open ") + path);
+
+        auto size = static_cast<size_t>(file.tellg());
+        std::vector<uint32_t> words(size / sizeof(uint32_t));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(words.data()), static_cast<std::streamsize>(words.size() * sizeof(uint32_t)));
+
+        FileHeader header{};
+        if (words.size() * sizeof(uint32_t) < sizeof(header)) throw std::runtime_error("Trace is empty");
+        memcpy(&header, words.data(), sizeof(header));
+        if (header.magic != FileMagic) throw std::runtime_error("Not a GL trace");
+        if (header.version != FormatVersion) {
+            throw std::runtime_error("Trace format version " + std::to_string(header.version) +
+                                     ", expected " + std::to_string(FormatVersion));
+        }
+        return words;
+    }
+
+    double millisecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    double percentile(std::vector<double> values, double p) {
+        if (values.empty()) return 0;
+        std::sort(values.begin(), values.end());
+        return values[std::min(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())))];
+    }
+
+    void usage() {
+        fprintf(stderr, "usage: gl_replay <trace> [--width W] [--height H] [--sync-calls] [--per-frame]\n");
+    }
+
+    Options parseOptions(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg = argv[i];
+            if (arg == "--width" && i + 1 < argc) options.width = atoi(argv[++i]);
+            else if (arg == "--height" && i + 1 < argc) options.height = atoi(argv[++i]);
+            else if (arg == "--sync-calls") options.syncCalls = true;
+            else if (arg == "--per-frame") options.perFrame = true;
+            else if (options.tracePath == nullptr && !arg.starts_with("--")) options.tracePath = argv[i];
+            else {
+                usage();
+                exit(2);
+            }
+        }
+        if (options.tracePath == nullptr) {
+            usage();
+            exit(2);
+        }
+        return options;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options = parseOptions(argc, argv);
+
+    try {
+        auto words = readTrace(options.tracePath);
+        createContext(options);
+        Replayer replayer(options);
+
+        std::array<CallStats, static_cast<size_t>(Op::Count)> callStats{};
+        std::vector<FrameStats> frames;
+
+        constexpr size_t FrameHeaderWords = sizeof(FrameHeader) / sizeof(uint32_t);
+        size_t position = sizeof(FileHeader) / sizeof(uint32_t);
+        while (position + FrameHeaderWords <= words.size()) {
+            FrameHeader frame{};
+            memcpy(&frame, words.data() + position, sizeof(frame));
+            if (frame.magic != FrameMagic) throw std::runtime_error("Corrupt frame at word " + std::to_string(position));
+            position += FrameHeaderWords;
+
+            size_t const frameEnd = position + frame.words;
+            if (frameEnd > words.size()) {
+                fprintf(stderr, "warning: frame %u is truncated, stopping\n", frame.index);
+                break;
+            }
+
+            auto const frameStart = Clock::now();
+            while (position < frameEnd) {
+                CallHeader header{};
+                memcpy(&header, words.data() + position, sizeof(header));
+                position++;
+
+                auto const op = static_cast<Op>(header.op);
+                if (header.op >= static_cast<uint16_t>(Op::Count)) {
+                    // the call header knows its length, so a newer trace can still be replayed without it
+                    fprintf(stderr, "warning: skipping unknown op %u\n", header.op);
+                    position += header.words;
+                    continue;
+                }
+
+                Reader reader(words.data() + position, header.words);
+                auto const callStart = Clock::now();
+                replayer.call(op, reader);
+                if (options.syncCalls) glFinish();
+                double const ms = millisecondsSince(callStart);
+                position += header.words;
+
+                auto& stats = callStats[header.op];
+                stats.count++;
+                stats.totalMs += ms;
+                stats.maxMs = std::max(stats.maxMs, ms);
+            }
+            double const submitMs = millisecondsSince(frameStart);
+            glFinish();
+            double const finishMs = millisecondsSince(frameStart);
+
+            frames.push_back({frame.index, frame.calls, frame.droppedCalls, submitMs, finishMs});
+
+            if (GLenum error = glGetError(); error != GL_NO_ERROR) {
+                fprintf(stderr, "warning: frame %u left GL error 0x%04x\n", frame.index, error);
+            }
+        }
+
+        if (options.perFrame) {
+            printf("%8s %8s %8s %12s %12s\n", "frame", "calls", "dropped", "submit ms", "finish ms");
+            for (auto const& frame : frames) {
+                printf("%8u %8u %8u %12.3f %12.3f\n", frame.index, frame.calls, frame.droppedCalls, frame.submitMs, frame.finishMs);
+            }
+            printf("\n");
+        }
+
+        printf("%-28s %10s %12s %12s %12s\n", "call", "count", "total ms", "mean us", "max us");
+        for (size_t i = 0; i < callStats.size(); i++) {
+            auto const& stats = callStats[i];
+            if (stats.count == 0) continue;
+            printf("%-28s %10llu %12.3f %12.3f %12.3f\n", opName(static_cast<Op>(i)),
+                   static_cast<unsigned long long>(stats.count), stats.totalMs,
+                   stats.totalMs * 1000.0 / static_cast<double>(stats.count), stats.maxMs * 1000.0);
+        }
+
+        // the first frame carries the initialization, keep it out of the steady state numbers
+        std::vector<double> steadyFrames;
+        uint32_t droppedCalls = 0;
+        for (size_t i = 0; i < frames.size(); i++) {
+            droppedCalls += frames[i].droppedCalls;
+            if (i > 0) steadyFrames.push_back(frames[i].finishMs);
+        }
+
+        printf("\n%zu frames", frames.size());
+        if (!steadyFrames.empty()) {
+            double total = 0;
+            for (double ms : steadyFrames) total += ms;
+            printf(", excluding the first: mean %.3f ms, p50 %.3f ms, p95 %.3f ms, max %.3f ms",
+                   total / static_cast<double>(steadyFrames.size()),
+                   percentile(steadyFrames, 0.5), percentile(steadyFrames, 0.95),
+                   *std::max_element(steadyFrames.begin(), steadyFrames.end()));
+        }
+        printf("\n");
+        if (droppedCalls > 0) {
+            printf("warning: %u calls were dropped while recording, the replay is incomplete\n", droppedCalls);
+        }
+    } catch (std::exception const& e) {
+        fprintf(stderr, "error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}